@@ -0,0 +1,237 @@
+#ifndef ANNEALING_H
+#define ANNEALING_H
+
+#include <algorithm>
+#include <cmath>
+#include "telemetry.h"
+#include "rng.h"
+
+class Solution {
+public:
+    virtual void applyMutation(class MutationOperator&) = 0;
+    virtual void undoMutation(class MutationOperator&) = 0;
+    virtual double getCost() const = 0;
+    virtual Solution* clone() const = 0;
+    // Копирует состояние other в уже существующий объект, переиспользуя его память.
+    virtual void copyFrom(const Solution& other) = 0;
+    virtual ~Solution() {}
+};
+
+class MutationOperator {
+public:
+    virtual void mutate(Solution& sol) = 0;
+    // Откатывает последний выполненный mutate() этого оператора.
+    virtual void undo(Solution& sol) = 0;
+    // Итог последнего mutate(): принят ли ход и как он изменил стоимость. Нужен адаптивным операторам.
+    virtual void feedback(bool, double) {}
+    // Текущая температура ИО; нужна операторам, которые сами выбирают ход из нескольких.
+    virtual void setTemperature(double) {}
+    virtual ~MutationOperator() {}
+};
+
+class CoolingSchedule {
+public:
+    virtual double getNextTemperature(double currTemp, int iter) const = 0;
+    virtual ~CoolingSchedule() {}
+};
+
+// Законы записаны отношением соседних температур, так что T_0 хранить не нужно.
+// Больцман: T_k = T_0 ln 2 / ln(k + 2); формула T / ln(1 + k) на шаге k = 0 делила на ln 1 = 0.
+class BoltzmannCooling final : public CoolingSchedule {
+public:
+    double getNextTemperature(double currTemp, int iter) const override {
+        return currTemp * std::log(iter + 2.0) / std::log(iter + 3.0);
+    }
+};
+
+// Коши: T_k = T_0 / (k + 1); деление текущей температуры на (1 + k) давало T_0 / k!.
+class CauchyCooling final : public CoolingSchedule {
+public:
+    double getNextTemperature(double currTemp, int iter) const override {
+        return currTemp * (iter + 1.0) / (iter + 2.0);
+    }
+};
+
+class LinearCooling final : public CoolingSchedule {
+public:
+    double getNextTemperature(double currTemp, int) const override {
+        return currTemp * 0.99;
+    }
+};
+
+// Постоянная температура: ступень лестницы в режиме обмена репликами (см. tempering.h).
+class FixedTemperature final : public CoolingSchedule {
+public:
+    double getNextTemperature(double currTemp, int) const override {
+        return currTemp;
+    }
+};
+
+// Правило Метрополиса: ход с приращением dF > 0 принимается с вероятностью exp(-dF/T).
+// Случайное число тянется только для ходов вверх, а при dF/T >= 37 вероятность меньше 2^-53,
+// и ход отвергается вообще без генератора. exp(-x) собирается из двух таблиц:
+// exp(-целая часть x) и exp(-дробная часть) с шагом 1/256 и линейной интерполяцией
+// (относительная погрешность меньше 2e-6, таблицы занимают 2.4 КБ).
+class Metropolis {
+    static constexpr int X_MAX = 37;
+    static constexpr int FRAC_STEPS = 256;
+
+    struct Tables {
+        double whole[X_MAX + 1];
+        double frac[FRAC_STEPS + 1];
+        Tables() {
+            for (int i = 0; i <= X_MAX; i++) whole[i] = std::exp(-double(i));
+            for (int j = 0; j <= FRAC_STEPS; j++) frac[j] = std::exp(-double(j) / FRAC_STEPS);
+        }
+    };
+    inline static const Tables tables;
+
+public:
+    // exp(-x) для 0 <= x < X_MAX.
+    static double expNeg(double x) {
+        int i = int(x);
+        double f = (x - i) * FRAC_STEPS;
+        int j = int(f);
+        double lo = tables.frac[j];
+        return tables.whole[i] * (lo + (tables.frac[j + 1] - lo) * (f - j));
+    }
+
+    template <class Gen>
+    static bool accept(double dF, double temp, Gen& gen) {
+        if (dF <= 0) return true;
+        double x = dF / temp;
+        if (!(x < X_MAX)) return false;  // в том числе temp == 0
+        return gen.uniform() < expNeg(x);
+    }
+};
+
+// Основной цикл ИО, параметризованный типами решения, мутации и закона охлаждения.
+// С абстрактными классами (см. SimulatedAnnealing) вызовы идут через виртуальные функции;
+// с конкретными final-классами компилятор разрешает их статически и встраивает в цикл.
+// От Sol требуются getCost(), clone() с возвращаемым типом Sol* и copyFrom(const Sol&),
+// от Mut — mutate(Sol&), undo(Sol&), feedback(bool, double) и setTemperature(double).
+template <class Sol, class Mut, class Cool>
+class SimulatedAnnealingT {
+    Sol* current;
+    Sol* best;
+    Mut* mutator;
+    Cool* cooler;
+    double temp;
+    int maxNoImprove;
+    long long iterations = 0;
+    long long accepted = 0;
+    long long improved = 0;
+    TelemetrySink* telemetry;
+    Rng gen;  // для правила Метрополиса
+public:
+    // telemetry == nullptr отключает журнал итераций.
+    SimulatedAnnealingT(Sol* initial, Mut* m, Cool* c, double startTemp, TelemetrySink* telemetry = nullptr,
+                        const Rng& gen = Rng())
+        : current(initial), best(initial->clone()), mutator(m), cooler(c), temp(startTemp), maxNoImprove(100),
+          telemetry(telemetry), gen(gen) {}
+
+    ~SimulatedAnnealingT() { delete current; }
+
+    // Мутации применяются к current на месте и откатываются при отказе.
+    // Копия лучшего решения снимается лениво: пока current остаётся лучшим (bestSaved == false),
+    // best не обновляется; снимок делается только когда принимается ход, уводящий с лучшего решения.
+    void run() {
+        int iter = 0, noImprove = 0;
+        double bestCost = best->getCost();
+        bool bestSaved = true;
+        if (telemetry) telemetry->beginRun();
+        mutator->setTemperature(temp);
+        while (noImprove < maxNoImprove) {
+            double prevCost = current->getCost();
+            mutator->mutate(*current);
+            double dF = current->getCost() - prevCost;
+            if (Metropolis::accept(dF, temp, gen)) {
+                mutator->feedback(true, dF);
+                accepted++;
+                if (dF < 0) improved++;
+                if (current->getCost() < bestCost) {
+                    bestCost = current->getCost();
+                    bestSaved = false;
+                    noImprove = 0;
+                } else {
+                    if (!bestSaved) {
+                        best->copyFrom(*current);
+                        mutator->undo(*best);
+                        bestSaved = true;
+                    }
+                    noImprove++;
+                }
+            } else {
+                mutator->feedback(false, dF);
+                mutator->undo(*current);
+                noImprove++;
+            }
+            if (telemetry) telemetry->sample(iter, temp, current->getCost(), bestCost);
+            temp = cooler->getNextTemperature(temp, iter);
+            mutator->setTemperature(temp);
+            iter++;
+        }
+        iterations += iter;
+        if (!bestSaved) best->copyFrom(*current);
+    }
+
+    // Ровно steps итераций без критерия останова. Состояние current и генератор сохраняются
+    // между вызовами: так реплика в tempering.h живёт на своей ступени температуры.
+    void sweep(long long steps) {
+        // Между вызовами current могли заменить извне (обмен репликами) решением лучше best.
+        double bestCost = std::min(best->getCost(), current->getCost());
+        bool bestSaved = best->getCost() <= current->getCost();
+        if (telemetry) telemetry->beginRun();
+        mutator->setTemperature(temp);
+        for (long long iter = 0; iter < steps; iter++) {
+            double prevCost = current->getCost();
+            mutator->mutate(*current);
+            double dF = current->getCost() - prevCost;
+            if (Metropolis::accept(dF, temp, gen)) {
+                mutator->feedback(true, dF);
+                accepted++;
+                if (dF < 0) improved++;
+                if (current->getCost() < bestCost) {
+                    bestCost = current->getCost();
+                    bestSaved = false;
+                } else if (!bestSaved) {
+                    best->copyFrom(*current);
+                    mutator->undo(*best);
+                    bestSaved = true;
+                }
+            } else {
+                mutator->feedback(false, dF);
+                mutator->undo(*current);
+            }
+            if (telemetry) telemetry->sample(iter, temp, current->getCost(), bestCost);
+            temp = cooler->getNextTemperature(temp, iter);
+            mutator->setTemperature(temp);
+        }
+        iterations += steps;
+        if (!bestSaved) best->copyFrom(*current);
+    }
+
+    // Продолжение с контрольной точки: температура и накопленные счётчики.
+    void restoreProgress(double t, long long iters, long long acc, long long imp) {
+        temp = t;
+        iterations = iters;
+        accepted = acc;
+        improved = imp;
+    }
+
+    Sol& getCurrent() { return *current; }
+    Sol* getBest() const { return best; }
+    long long getIterations() const { return iterations; }
+    long long getAccepted() const { return accepted; }
+    long long getImproved() const { return improved; }
+    double getTemperature() const { return temp; }
+    const Rng& rng() const { return gen; }
+};
+
+// Головной класс ИО на абстрактных классах решения, мутации и закона охлаждения.
+class SimulatedAnnealing : public SimulatedAnnealingT<Solution, MutationOperator, CoolingSchedule> {
+public:
+    using SimulatedAnnealingT::SimulatedAnnealingT;
+};
+
+#endif
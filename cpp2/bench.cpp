@@ -0,0 +1,195 @@
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "annealing.h"
+#include "schedule.h"
+#include "mutations.h"
+#include "transport.h"
+
+// Набор замеров внутри одного процесса: в измерение не попадают запуск main, разбор CSV и fork.
+// Каждый замер — строка (замер, N, M, вариант, значение, единица) в CSV или JSON.
+// Usage: ./bench [--format csv|json] [--seconds S] [--n 1000,14000] [--m 2,8]
+
+struct BenchResult {
+    std::string benchmark;
+    int N, M;
+    std::string variant;
+    double value;
+    std::string unit;
+};
+
+// Не даёт компилятору выбросить вычисление, результат которого не используется.
+volatile long long benchSink;
+
+// Повторяет body пачками, пока не пройдёт seconds; возвращает число вызовов в секунду.
+template <class F>
+double ops_per_second(double seconds, F body) {
+    long long ops = 0, batch = 1;
+    double elapsed = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while (elapsed < seconds) {
+        for (long long i = 0; i < batch; i++) body();
+        ops += batch;
+        if (batch < (1 << 20)) batch *= 2;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+    return ops / elapsed;
+}
+
+// Полные запуски ИО подряд; итераций в секунду.
+template <class SA, class Mut, class Cool>
+double iterations_per_second(const Schedule& start, Mut& mutator, double seconds) {
+    Cool cooler;
+    long long iters = 0;
+    double elapsed = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while (elapsed < seconds) {
+        SA sa(new Schedule(start), &mutator, &cooler, 100.0, nullptr);
+        sa.run();
+        iters += sa.getIterations();
+        delete sa.getBest();
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+    return iters / elapsed;
+}
+
+template <class Cool>
+void bench_cooling(const char* name, const Schedule& start, double seconds, std::vector<BenchResult>& out) {
+    int N = start.N, M = start.M;
+    SwapMutation swap;
+    PortfolioMutation portfolio(Rng(), (1u << PortfolioMutation::KIND_COUNT) - 1);
+    double virt = iterations_per_second<SimulatedAnnealing, SwapMutation, Cool>(start, swap, seconds);
+    double tmpl = iterations_per_second<SimulatedAnnealingT<Schedule, SwapMutation, Cool>, SwapMutation, Cool>(
+        start, swap, seconds);
+    double port = iterations_per_second<SimulatedAnnealingT<Schedule, PortfolioMutation, Cool>, PortfolioMutation, Cool>(
+        start, portfolio, seconds);
+    MultiSwapMutation multi;
+    double multiRate = iterations_per_second<SimulatedAnnealingT<Schedule, MultiSwapMutation, Cool>, MultiSwapMutation, Cool>(
+        start, multi, seconds);
+    out.push_back({"sa_iterations", N, M, std::string(name) + "/virtual", virt, "iter/s"});
+    out.push_back({"sa_iterations", N, M, std::string(name) + "/template", tmpl, "iter/s"});
+    out.push_back({"sa_iterations", N, M, std::string(name) + "/portfolio", port, "iter/s"});
+    out.push_back({"sa_iterations", N, M, std::string(name) + "/multiswap8", multiRate, "iter/s"});
+}
+
+// Пересылка расписаний через пару сокетов: приём в отдельном потоке, отправка в текущем.
+double transfers_per_second(const Schedule& s, double seconds) {
+    int sv[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    std::thread receiver([&]() {
+        Schedule received(s.M, JobTable{}, std::vector<std::vector<int>>(s.M));
+        while (try_recv_schedule(sv[0], received)) {}
+    });
+    long long count = 0;
+    double elapsed = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while (elapsed < seconds) {
+        send_schedule(sv[1], s);
+        count++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+    send_stop(sv[1]);
+    receiver.join();
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    close(sv[0]);
+    close(sv[1]);
+    return count / elapsed;
+}
+
+void bench_instance(int N, int M, double seconds, std::vector<BenchResult>& out) {
+    Rng gen(12345);
+    std::vector<int> jobDurations(N);
+    for (int& d : jobDurations) d = 1 + gen.below(100);
+    Schedule start(M, jobDurations, gen);
+
+    Schedule s(start);
+    out.push_back({"getCost", N, M, "cached", ops_per_second(seconds, [&]() { benchSink = s.getCost(); }), "op/s"});
+    out.push_back({"recomputeCost", N, M, "full", ops_per_second(seconds, [&]() {
+        s.recomputeCost();
+        benchSink = s.cost;
+    }), "op/s"});
+    out.push_back({"swapJobsRandom", N, M, "K2", ops_per_second(seconds, [&]() { s.swapJobsRandom(gen); }), "op/s"});
+    JobTable k1Table = start.table;
+    k1Table.criterion = Criterion::K1;
+    Schedule k1(M, k1Table, gen);
+    out.push_back({"swapJobsRandom", N, M, "K1", ops_per_second(seconds, [&]() { k1.swapJobsRandom(gen); }), "op/s"});
+    out.push_back({"clone", N, M, "new", ops_per_second(seconds, [&]() { delete s.clone(); }), "op/s"});
+    Schedule copy(start);
+    out.push_back({"clone", N, M, "copyFrom", ops_per_second(seconds, [&]() { copy.copyFrom(s); }), "op/s"});
+
+    // Сообщение: M, N, критерий, N длительностей, M счётчиков и N номеров работ.
+    double bytes = (3.0 + 2.0 * N + M) * sizeof(int);
+    double sends = transfers_per_second(s, seconds);
+    out.push_back({"send_recv_schedule", N, M, "socketpair", sends, "schedule/s"});
+    out.push_back({"send_recv_schedule", N, M, "socketpair", sends * bytes / 1e6, "MB/s"});
+
+    ShmExchange shm(start.table, M, 1);
+    out.push_back({"shm_store_load", N, M, "", ops_per_second(seconds, [&]() {
+        shm.store(0, 0, s);
+        shm.load(0, 0, copy);
+    }), "op/s"});
+
+    bench_cooling<BoltzmannCooling>("B", start, seconds, out);
+    bench_cooling<CauchyCooling>("C", start, seconds, out);
+    bench_cooling<LinearCooling>("L", start, seconds, out);
+}
+
+std::vector<int> parse_list(const char* arg) {
+    std::vector<int> values;
+    std::stringstream s(arg);
+    std::string item;
+    while (std::getline(s, item, ','))
+        values.push_back(std::atoi(item.c_str()));
+    return values;
+}
+
+void print_csv(const std::vector<BenchResult>& results) {
+    std::cout << "Benchmark,N,M,Variant,Value,Unit\n";
+    for (const BenchResult& r : results)
+        std::cout << r.benchmark << "," << r.N << "," << r.M << "," << r.variant << ","
+                  << r.value << "," << r.unit << "\n";
+}
+
+void print_json(const std::vector<BenchResult>& results) {
+    std::cout << "[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        std::cout << "  {\"benchmark\": \"" << r.benchmark << "\", \"N\": " << r.N << ", \"M\": " << r.M
+                  << ", \"variant\": \"" << r.variant << "\", \"value\": " << r.value
+                  << ", \"unit\": \"" << r.unit << "\"}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    std::cout << "]\n";
+}
+
+int main(int argc, char* argv[]) {
+    bool json = false;
+    double seconds = 0.2;
+    std::vector<int> Ns = {1000, 14000, 100000};
+    std::vector<int> Ms = {2, 8, 64};
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--format" && hasValue) json = std::strcmp(argv[++i], "json") == 0;
+        else if (arg == "--seconds" && hasValue) seconds = std::atof(argv[++i]);
+        else if (arg == "--n" && hasValue) Ns = parse_list(argv[++i]);
+        else if (arg == "--m" && hasValue) Ms = parse_list(argv[++i]);
+        else {
+            std::cout << "Usage: ./bench [--format csv|json] [--seconds S] [--n 1000,14000] [--m 2,8]\n";
+            return 1;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    for (int N : Ns)
+        for (int M : Ms)
+            bench_instance(N, M, seconds, results);
+    if (json) print_json(results);
+    else print_csv(results);
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "annealing.h"
+#include "schedule.h"
+#include "mutations.h"
+#include "rng.h"
+
+// Проверка инкрементального пересчёта критерия: случайные обмены, переносы и мутации
+// с откатами для K1 и K2. После каждого хода кэш (cost, loads, дерево времён завершения)
+// сверяется с расписанием, собранным заново из той же записи, а K1 — ещё и с прямым
+// подсчётом по определению. После отката расписание должно совпасть с состоянием до хода.
+// Малые N и M, чтобы часто попадались пустые процессоры, соседние позиции и переразметка
+// областей; отдельно процессоры опустошаются переносами всех их работ.
+// Usage: ./check [--steps S]
+
+int failures = 0;
+
+void fail(const std::string& what, const std::string& where, long long got, long long want) {
+    if (failures++ < 20)
+        std::cerr << "FAIL " << where << ": " << what << " = " << got << ", expected " << want << "\n";
+}
+
+// Сверяет кэш sch с полным пересчётом по компактной записи.
+void check_cache(const Schedule& sch, const std::string& where) {
+    std::vector<int> sizes(sch.M), compact(sch.N);
+    sch.exportTo(sizes.data(), compact.data());
+    Schedule fresh(sch.M, sch.table, sizes.data(), compact.data());
+    if (sch.cost != fresh.cost) fail("cost", where, sch.cost, fresh.cost);
+    if ((long long)sch.getCost() != fresh.cost) fail("getCost()", where, (long long)sch.getCost(), fresh.cost);
+    for (int p = 0; p < sch.M; p++)
+        if (sch.loads[p] != fresh.loads[p]) fail("loads[" + std::to_string(p) + "]", where, sch.loads[p], fresh.loads[p]);
+    if (sch.table.criterion != Criterion::K1) return;
+    // K1 = Tmax - Tmin по временам завершения работ: пустые процессоры не участвуют,
+    // раньше всех на процессоре завершается первая работа, позже всех — последняя.
+    long long tmin = CompletionTree::NONE_LO, tmax = CompletionTree::NONE_HI;
+    for (int p = 0; p < sch.M; p++) {
+        auto jobs = sch.processor(p);
+        if (jobs.empty()) continue;
+        long long end = 0;
+        for (int job : jobs) end += sch.jobTimes[job];
+        tmin = std::min(tmin, (long long)sch.jobTimes[jobs[0]]);
+        tmax = std::max(tmax, end);
+    }
+    long long k1 = tmin <= tmax ? tmax - tmin : 0;
+    if (sch.cost != k1) fail("K1 by definition", where, sch.cost, k1);
+    long long mn = CompletionTree::NONE_LO, mx = CompletionTree::NONE_HI;
+    sch.completions.query(0, sch.M, mn, mx);
+    if (mn != tmin) fail("completions Tmin", where, mn, tmin);
+    if (mx != tmax) fail("completions Tmax", where, mx, tmax);
+}
+
+// Расписание как последовательности работ процессоров, без запаса в областях.
+std::vector<std::vector<int>> layout(const Schedule& sch) {
+    std::vector<std::vector<int>> out;
+    for (int p = 0; p < sch.M; p++) {
+        auto jobs = sch.processor(p);
+        out.emplace_back(jobs.begin(), jobs.end());
+    }
+    return out;
+}
+
+// Откат должен вернуть и расписание, и кэш к состоянию до хода.
+void check_undo(const Schedule& sch, const std::vector<std::vector<int>>& before, long long costBefore,
+                const std::string& where) {
+    if (layout(sch) != before) fail("layout differs after undo", where, 0, 0);
+    if (sch.cost != costBefore) fail("cost after undo", where, sch.cost, costBefore);
+    check_cache(sch, where + " undo");
+}
+
+Schedule random_schedule(Rng& gen, Criterion criterion, int N, int M) {
+    std::vector<int> times(N);
+    for (int& t : times) t = 1 + gen.below(100);
+    JobTable table = JobTable::fromVector(times);
+    table.criterion = criterion;
+    return Schedule(M, table, gen);
+}
+
+// Ходы SwapMove и ShiftMove напрямую через deltaCost/applyMove, включая ходы внутри процессора.
+void check_moves(Rng& gen, Criterion criterion, int N, int M, int steps, const std::string& name) {
+    Schedule sch = random_schedule(gen, criterion, N, M);
+    check_cache(sch, name + " initial");
+    for (int step = 0; step < steps; step++) {
+        std::string where = name + " step " + std::to_string(step);
+        auto before = layout(sch);
+        long long costBefore = sch.cost;
+        bool undo = gen.below(2);
+        int p1 = gen.below(M), p2 = gen.below(M);
+        if (gen.below(2)) {
+            if (!sch.jobCount(p1) || !sch.jobCount(p2)) continue;
+            SwapMove mv{p1, (int)gen.below(sch.jobCount(p1)), p2, (int)gen.below(sch.jobCount(p2))};
+            long long delta = sch.deltaCost(mv);
+            sch.applyMove(mv, delta);
+            check_cache(sch, where + " swap");
+            if (undo) {
+                sch.applyMove(mv, -delta);
+                check_undo(sch, before, costBefore, where + " swap");
+            }
+        } else {
+            if (!sch.jobCount(p1)) continue;
+            int i1 = gen.below(sch.jobCount(p1));
+            // После переноса на другой процессор на нём на одну работу больше.
+            int i2 = gen.below(sch.jobCount(p2) + (p1 != p2));
+            ShiftMove mv{p1, i1, p2, i2};
+            long long delta = sch.deltaCost(mv);
+            sch.applyMove(mv, delta);
+            check_cache(sch, where + " shift");
+            if (undo) {
+                sch.applyMove(ShiftMove{p2, i2, p1, i1}, -delta);
+                check_undo(sch, before, costBefore, where + " shift");
+            }
+        }
+    }
+}
+
+// Все работы процессора p по одной переносятся на следующий процессор (в начало или в конец),
+// пока p не опустеет, затем переносы откатываются в обратном порядке.
+void check_emptying(Rng& gen, Criterion criterion, int N, int M, const std::string& name) {
+    Schedule sch = random_schedule(gen, criterion, N, M);
+    for (int p = 0; p < M; p++) {
+        int q = (p + 1) % M;
+        std::vector<std::pair<ShiftMove, long long>> done;
+        std::vector<std::vector<std::vector<int>>> layouts;
+        std::vector<long long> costs;
+        while (sch.jobCount(p) > 0) {
+            std::string where = name + " empty p=" + std::to_string(p) + " step " + std::to_string(done.size());
+            int i1 = gen.below(sch.jobCount(p));
+            ShiftMove mv{p, i1, q, gen.below(2) ? 0 : sch.jobCount(q)};
+            layouts.push_back(layout(sch));
+            costs.push_back(sch.cost);
+            long long delta = sch.deltaCost(mv);
+            sch.applyMove(mv, delta);
+            done.push_back({mv, delta});
+            check_cache(sch, where);
+        }
+        while (!done.empty()) {
+            auto [mv, delta] = done.back();
+            std::string where = name + " refill p=" + std::to_string(p) + " step " + std::to_string(done.size() - 1);
+            sch.applyMove(ShiftMove{mv.p2, mv.i2, mv.p1, mv.i1}, -delta);
+            check_undo(sch, layouts.back(), costs.back(), where);
+            done.pop_back();
+            layouts.pop_back();
+            costs.pop_back();
+        }
+        // Следующий процессор остаётся с перенесёнными работами, p — пустым.
+        while (sch.jobCount(p) > 0) {
+            ShiftMove mv{p, 0, q, 0};
+            sch.applyMove(mv, sch.deltaCost(mv));
+        }
+        check_cache(sch, name + " emptied p=" + std::to_string(p));
+    }
+}
+
+// Операторы мутации через applyMutation/undoMutation, как их вызывает отжиг.
+template <class Mut>
+void check_mutation(Rng& gen, Criterion criterion, int N, int M, int steps, Mut mut, const std::string& name) {
+    Schedule sch = random_schedule(gen, criterion, N, M);
+    for (int step = 0; step < steps; step++) {
+        std::string where = name + " step " + std::to_string(step);
+        auto before = layout(sch);
+        long long costBefore = sch.cost;
+        sch.applyMutation(mut);
+        check_cache(sch, where);
+        if (gen.below(2)) {
+            sch.undoMutation(mut);
+            check_undo(sch, before, costBefore, where);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    int steps = 2000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::string(argv[i]) == "--steps") steps = std::stoi(argv[i + 1]);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--steps S]\n";
+            return 1;
+        }
+    }
+
+    Rng gen(12345);
+    const int sizes[][2] = {{1, 1}, {5, 1}, {2, 3}, {7, 3}, {40, 4}, {200, 16}};
+    for (Criterion criterion : {Criterion::K2, Criterion::K1}) {
+        std::string crit = criterion == Criterion::K1 ? "K1" : "K2";
+        for (auto [N, M] : sizes) {
+            std::string shape = crit + " N=" + std::to_string(N) + " M=" + std::to_string(M);
+            check_moves(gen, criterion, N, M, steps, shape + " moves");
+            if (M > 1) check_emptying(gen, criterion, N, M, shape);
+            check_mutation(gen, criterion, N, M, steps, SwapMutation(Rng(gen())), shape + " swap");
+            for (int k = 0; k < PortfolioMutation::KIND_COUNT; k++) {
+                PortfolioMutation one(Rng(gen()), 1u << k);
+                check_mutation(gen, criterion, N, M, steps, one,
+                               shape + " " + PortfolioMutation::NAMES[k]);
+            }
+            check_mutation(gen, criterion, N, M, steps,
+                           PortfolioMutation(Rng(gen()), PortfolioMutation::parseMask("portfolio")),
+                           shape + " portfolio");
+        }
+    }
+
+    if (failures) {
+        std::cerr << failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << "OK\n";
+    return 0;
+}
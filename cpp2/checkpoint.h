@@ -0,0 +1,168 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "schedule.h"
+#include "mutations.h"
+#include "jobfile.h"
+#include "transport.h"
+
+// Контрольные точки долгих запусков в памяти одного процесса (--threads, --tempering).
+// Точка снимается на барьере между раундами, когда все рабочие стоят, поэтому в ней нет
+// незавершённых ходов. Файл:
+//   CheckpointHeader,
+//   replicas записей ReplicaRecord (состояние рабочего),
+//   schedules расписаний в компактной записи: M чисел работ процессоров и N номеров работ.
+// Все части фиксированного размера и выровнены по 8 байт, так что файл можно читать прямо
+// из отображения. Расписания записываются перестановкой работ, без запаса областей процессоров.
+
+const char CHECKPOINT_MAGIC[8] = {'S', 'A', 'C', 'K', 'P', 'T', '1', '\0'};
+
+enum class CheckpointMode : uint32_t {
+    Threads = 0,    // одно расписание — старт следующего раунда
+    Tempering = 1   // по два расписания на реплику: текущее и лучшее
+};
+
+struct CheckpointHeader {
+    char magic[8];
+    CheckpointMode mode;
+    int32_t N, M;
+    int32_t replicas;
+    int32_t schedules;
+    int32_t round;        // сколько раундов уже пройдено
+    int32_t noImprove;    // раундов подряд без улучшения глобального решения
+    Criterion criterion;
+    uint64_t seed;
+    uint64_t jobsHash;    // работы при возобновлении должны совпасть с сохранёнными
+    double globalBest;
+    Rng master;           // генератор мастера
+};
+
+struct ReplicaRecord {
+    double temp;
+    long long iterations, accepted, improved;
+    Rng accept;                       // генератор правила Метрополиса
+    PortfolioMutation::State mutator;
+};
+
+static_assert(std::is_trivially_copyable_v<CheckpointHeader> && std::is_trivially_copyable_v<ReplicaRecord>);
+static_assert(sizeof(CheckpointHeader) % 8 == 0 && sizeof(ReplicaRecord) % 8 == 0);
+
+// FNV-1a по длительностям работ.
+inline uint64_t jobs_hash(const JobTable& jobs) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(jobs.times);
+    for (size_t i = 0; i < size_t(jobs.size) * sizeof(int); i++) h = (h ^ p[i]) * 0x100000001b3ULL;
+    return h;
+}
+
+struct Checkpoint {
+    CheckpointHeader header = {};
+    std::vector<ReplicaRecord> replicas;
+    std::vector<int> schedules;  // header.schedules блоков по M + N чисел
+
+    Checkpoint(CheckpointMode mode, const JobTable& jobs, int M, uint64_t seed) {
+        std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+        header.mode = mode;
+        header.N = jobs.size;
+        header.M = M;
+        header.seed = seed;
+        header.jobsHash = jobs_hash(jobs);
+        header.criterion = jobs.criterion;
+    }
+
+    void addSchedule(const Schedule& s) {
+        size_t at = schedules.size();
+        schedules.resize(at + s.M + s.N);
+        s.exportTo(schedules.data() + at, schedules.data() + at + s.M);
+        header.schedules++;
+    }
+
+    Schedule schedule(int i, const JobTable& jobs) const {
+        const int* block = schedules.data() + size_t(i) * (header.M + header.N);
+        return Schedule(header.M, jobs, block, block + header.M);
+    }
+
+    // Запись во временный файл рядом и rename(): на диске всегда целая точка, старая или новая.
+    void save(const std::string& path) {
+        header.replicas = replicas.size();
+        std::string tmp = path + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            throw std::runtime_error("Ошибка создания файла " + tmp);
+        bool ok = write_all(fd, &header, sizeof(header)) &&
+                  write_all(fd, replicas.data(), replicas.size() * sizeof(ReplicaRecord)) &&
+                  write_all(fd, schedules.data(), schedules.size() * sizeof(int)) && fsync(fd) == 0;
+        close(fd);
+        if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0)
+            throw std::runtime_error("Ошибка записи контрольной точки " + path);
+    }
+
+    // Читает точку и проверяет, что она снята в том же режиме на тех же данных.
+    static Checkpoint load(const std::string& path, CheckpointMode mode, const JobTable& jobs, int M) {
+        size_t size;
+        std::shared_ptr<const char> data = map_file(path.c_str(), size);
+        Checkpoint c(mode, jobs, M, 0);
+        CheckpointHeader expected = c.header;
+        if (size < sizeof(CheckpointHeader))
+            throw std::runtime_error("Повреждённая контрольная точка " + path);
+        std::memcpy(&c.header, data.get(), sizeof(CheckpointHeader));
+        const CheckpointHeader& h = c.header;
+        if (std::memcmp(h.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 || h.mode != mode || h.N != expected.N ||
+            h.M != M || h.jobsHash != expected.jobsHash || h.criterion != expected.criterion || h.replicas < 0 ||
+            h.schedules < 0)
+            throw std::runtime_error("Контрольная точка " + path + " снята в другом режиме или на других данных");
+        size_t replicaBytes = size_t(h.replicas) * sizeof(ReplicaRecord);
+        size_t scheduleInts = size_t(h.schedules) * (h.M + h.N);
+        if (size != sizeof(CheckpointHeader) + replicaBytes + scheduleInts * sizeof(int))
+            throw std::runtime_error("Повреждённая контрольная точка " + path);
+        const char* p = data.get() + sizeof(CheckpointHeader);
+        c.replicas.resize(h.replicas);
+        std::memcpy(c.replicas.data(), p, replicaBytes);
+        c.schedules.resize(scheduleInts);
+        std::memcpy(c.schedules.data(), p + replicaBytes, scheduleInts * sizeof(int));
+        return c;
+    }
+};
+
+// Когда снимать точки: не чаще раза в interval секунд, чтобы запись не занимала заметную
+// долю времени работы. resumed — точка, с которой продолжается запуск (--resume).
+class Checkpointer {
+    std::string path;
+    double interval;
+    std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+public:
+    std::optional<Checkpoint> resumed;
+
+    Checkpointer(const std::string& path, double interval) : path(path), interval(interval) {}
+
+    bool due() {
+        if (path.empty()) return false;
+        auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration<double>(now - last).count() < interval) return false;
+        last = now;
+        return true;
+    }
+
+    // Ошибка записи не прерывает расчёт: сообщение в stderr, следующая попытка — через interval.
+    void save(Checkpoint& c) {
+        try {
+            c.save(path);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "schedule.h"
+#include "transport.h"
+
+// Резидентный решатель: один процесс с пулом прогретых рабочих потоков принимает на UNIX-сокете
+// поток задач и отвечает расписаниями. Запуск процесса, разбор файла и fork() оплачиваются
+// один раз, а не на каждый экземпляр задачи.
+//
+// Соединение несёт любое число запросов подряд; каждый запрос — независимая задача, которую
+// решает один рабочий пула, поэтому запросы одного или разных клиентов решаются параллельно,
+// а ответы приходят по мере готовности. Запрос и ответ сопоставляются по id.
+
+const uint32_t DAEMON_MAGIC = 0x53414431;  // "SAD1"
+const int32_t DAEMON_MAX_JOBS = 1 << 26;
+
+// Значения совпадают с Criterion.
+enum DaemonCriterion : int32_t {
+    CriterionK2 = 0,
+    CriterionK1 = 1
+};
+
+enum DaemonStatus : int32_t {
+    DaemonOk = 0,
+    DaemonBadRequest = 1,            // кадр не разобран; сервер закрывает соединение
+    DaemonUnsupportedCriterion = 2,
+    DaemonSolverError = 3
+};
+
+// Кадр запроса: заголовок, затем N длительностей работ (int32).
+struct DaemonRequest {
+    uint32_t magic;
+    uint32_t id;          // возвращается в ответе без изменений
+    int32_t M, N;
+    int32_t criterion;    // DaemonCriterion
+    int32_t budget;       // число запусков ИО, каждый продолжает с лучшего найденного расписания
+    uint64_t seed;
+};
+
+// Кадр ответа: заголовок, затем при status == DaemonOk компактная запись расписания
+// (M чисел работ процессоров и N номеров работ, см. Schedule::exportTo).
+struct DaemonReply {
+    uint32_t id;
+    int32_t status;       // DaemonStatus
+    int32_t M, N;         // 0, если расписания в ответе нет
+    int64_t cost;
+};
+
+// Решатель одной задачи; вызывается из рабочих потоков пула одновременно.
+using DaemonSolver = std::function<Schedule(const DaemonRequest&, const JobTable&)>;
+
+// ----------- Клиентская сторона -----------
+
+inline bool daemon_send_request(int sock, const DaemonRequest& req, const int* times) {
+    return write_all(sock, &req, sizeof(req)) && write_all(sock, times, size_t(req.N) * sizeof(int));
+}
+
+// Принимает ответ; compact получает M + N чисел при status == DaemonOk.
+inline bool daemon_recv_reply(int sock, DaemonReply& reply, std::vector<int>& compact) {
+    if (!read_all(sock, &reply, sizeof(reply))) return false;
+    compact.resize(size_t(reply.M) + reply.N);
+    return read_all(sock, compact.data(), compact.size() * sizeof(int));
+}
+
+// ----------- Сервер -----------
+
+class SolverDaemon {
+    // Соединение закрывается, когда его отпустят и читающий поток, и все задачи из него.
+    struct Connection {
+        int fd;
+        std::mutex writeMutex;  // ответы разных рабочих не должны перемешаться
+        explicit Connection(int fd) : fd(fd) {}
+        ~Connection() { close(fd); }
+    };
+
+    struct Task {
+        std::shared_ptr<Connection> conn;
+        DaemonRequest req;
+        std::vector<int> times;
+    };
+
+    DaemonSolver solve;
+    std::deque<Task> queue;
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    bool stopping = false;
+    std::vector<std::thread> pool;
+
+    // Открытые соединения и число читающих потоков — чтобы при останове дождаться читателей.
+    std::mutex connMutex;
+    std::condition_variable readersDone;
+    std::vector<std::weak_ptr<Connection>> conns;
+    int readers = 0;
+
+    static volatile std::sig_atomic_t terminate;
+    static void onSignal(int) { terminate = 1; }
+
+    static void reply(Connection& conn, const DaemonReply& header, const std::vector<int>& compact) {
+        std::lock_guard<std::mutex> lock(conn.writeMutex);
+        write_all(conn.fd, &header, sizeof(header));
+        write_all(conn.fd, compact.data(), compact.size() * sizeof(int));
+    }
+
+    void workerLoop() {
+        for (;;) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [&] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                task = std::move(queue.front());
+                queue.pop_front();
+            }
+            DaemonReply header = {task.req.id, DaemonOk, 0, 0, 0};
+            std::vector<int> compact;
+            try {
+                JobTable jobs = JobTable::fromVector(std::move(task.times));
+                jobs.criterion = Criterion(task.req.criterion);
+                Schedule best = solve(task.req, jobs);
+                header.M = best.M;
+                header.N = best.N;
+                header.cost = best.cost;
+                compact.resize(size_t(best.M) + best.N);
+                best.exportTo(compact.data(), compact.data() + best.M);
+            } catch (const std::exception&) {
+                header.status = DaemonSolverError;
+            }
+            reply(*task.conn, header, compact);
+        }
+    }
+
+    void runReader(std::shared_ptr<Connection> conn) {
+        readLoop(std::move(conn));
+        std::lock_guard<std::mutex> lock(connMutex);
+        readers--;
+        readersDone.notify_all();
+    }
+
+    // Читает кадры соединения и ставит задачи в очередь, пока клиент не закроет соединение.
+    void readLoop(std::shared_ptr<Connection> conn) {
+        DaemonRequest req;
+        while (read_all(conn->fd, &req, sizeof(req))) {
+            if (req.magic != DAEMON_MAGIC || req.M <= 0 || req.N < 0 || req.N > DAEMON_MAX_JOBS) {
+                reply(*conn, DaemonReply{req.id, DaemonBadRequest, 0, 0, 0}, {});
+                return;
+            }
+            std::vector<int> times(req.N);
+            if (!read_all(conn->fd, times.data(), times.size() * sizeof(int))) return;
+            if (req.criterion != CriterionK2 && req.criterion != CriterionK1) {
+                reply(*conn, DaemonReply{req.id, DaemonUnsupportedCriterion, 0, 0, 0}, {});
+                continue;
+            }
+            if (req.budget < 1) req.budget = 1;
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                queue.push_back(Task{conn, req, std::move(times)});
+            }
+            queueReady.notify_one();
+        }
+    }
+
+public:
+    SolverDaemon(int workers, DaemonSolver solve) : solve(std::move(solve)) {
+        for (int i = 0; i < workers; i++)
+            pool.emplace_back(&SolverDaemon::workerLoop, this);
+    }
+
+    SolverDaemon(const SolverDaemon&) = delete;
+    SolverDaemon& operator=(const SolverDaemon&) = delete;
+
+    // Рабочие дорешивают уже принятые задачи и завершаются.
+    ~SolverDaemon() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        for (std::thread& t : pool) t.join();
+    }
+
+    // Принимает соединения на сокете path до SIGINT или SIGTERM.
+    void serve(const std::string& path) {
+        int listenSock = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(path.c_str());
+        if (bind(listenSock, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenSock, 64) < 0) {
+            close(listenSock);
+            throw std::runtime_error("Cannot listen on " + path);
+        }
+        // Сигнал может достаться любому потоку, поэтому флаг проверяется между ожиданиями poll().
+        struct sigaction sa = {};
+        sa.sa_handler = onSignal;
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+        signal(SIGPIPE, SIG_IGN);  // клиент может уйти, не дождавшись ответа
+        pollfd pfd = {listenSock, POLLIN, 0};
+        while (!terminate) {
+            if (poll(&pfd, 1, 200) <= 0) continue;
+            int fd = accept(listenSock, nullptr, nullptr);
+            if (fd < 0) continue;
+            auto conn = std::make_shared<Connection>(fd);
+            {
+                std::lock_guard<std::mutex> lock(connMutex);
+                std::erase_if(conns, [](const std::weak_ptr<Connection>& c) { return c.expired(); });
+                conns.push_back(conn);
+                readers++;
+            }
+            std::thread(&SolverDaemon::runReader, this, std::move(conn)).detach();
+        }
+        close(listenSock);
+        unlink(path.c_str());
+        // Новых запросов не принимаем; ответы на уже принятые ещё можно отправить.
+        std::unique_lock<std::mutex> lock(connMutex);
+        for (const std::weak_ptr<Connection>& c : conns)
+            if (auto conn = c.lock()) shutdown(conn->fd, SHUT_RD);
+        readersDone.wait(lock, [&] { return readers == 0; });
+    }
+};
+
+inline volatile std::sig_atomic_t SolverDaemon::terminate = 0;
+
+#endif
@@ -0,0 +1,216 @@
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "schedule.h"
+#include "daemon.h"
+#include "rng.h"
+
+// Проверка резидентного решателя через его протокол: запускает ./main --daemon и, как клиент,
+// шлёт запросы K1 и K2 с нескольких соединений одновременно, по несколько подряд на каждом.
+// Каждый ответ сверяется с запросом: id, M и N, компактная запись — перестановка работ,
+// cost — критерий запроса на этом расписании. Затем кадры с ошибками: неизвестный критерий
+// (соединение остаётся открытым), плохой заголовок (ответ и закрытие), обрезанный кадр
+// (закрытие без ответа). В конце SIGINT: процесс завершается с кодом 0, сокет удаляется,
+// открытые соединения закрываются.
+// Usage: ./daemon_check [path to main (default ./main)]
+
+int failures = 0;
+std::mutex failMutex;
+
+void fail(const std::string& what) {
+    std::lock_guard<std::mutex> lock(failMutex);
+    if (failures++ < 20) std::cerr << "FAIL " << what << "\n";
+}
+
+int connect_to(const std::string& path) {
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+DaemonRequest make_request(uint32_t id, int M, int N, int32_t criterion) {
+    return DaemonRequest{DAEMON_MAGIC, id, M, N, criterion, 1, 1000 + id};
+}
+
+std::vector<int> random_times(Rng& gen, int N) {
+    std::vector<int> times(N);
+    for (int& t : times) t = 1 + gen.below(100);
+    return times;
+}
+
+// Ответ DaemonOk на запрос req с длительностями times: компактная запись корректна,
+// а cost совпадает с критерием запроса, пересчитанным по этой записи.
+void check_reply(const DaemonRequest& req, const std::vector<int>& times, const DaemonReply& reply,
+                 const std::vector<int>& compact) {
+    std::string where = "request " + std::to_string(req.id) + ": ";
+    if (reply.status != DaemonOk) return fail(where + "status " + std::to_string(reply.status));
+    if (reply.M != req.M || reply.N != req.N) return fail(where + "wrong M or N in the reply");
+    std::vector<int> seen(req.N, 0);
+    int total = 0;
+    for (int p = 0; p < req.M; p++) total += compact[p];
+    if (total != req.N) return fail(where + "processor sizes do not sum to N");
+    for (int k = 0; k < req.N; k++) {
+        int job = compact[req.M + k];
+        if (job < 0 || job >= req.N || seen[job]++) return fail(where + "jobs are not a permutation");
+    }
+    JobTable table = JobTable::fromVector(times);
+    table.criterion = Criterion(req.criterion);
+    Schedule s(req.M, table, compact.data(), compact.data() + req.M);
+    if (reply.cost != s.cost)
+        fail(where + "cost " + std::to_string(reply.cost) + ", criterion gives " + std::to_string(s.cost));
+}
+
+// Одно соединение: count запросов подряд без ожидания ответов, затем ответы в любом порядке.
+void client(const std::string& path, int client_id, int count) {
+    int sock = connect_to(path);
+    if (sock < 0) return fail("client " + std::to_string(client_id) + " cannot connect");
+    Rng gen(client_id + 1);
+    std::map<uint32_t, std::pair<DaemonRequest, std::vector<int>>> sent;
+    for (int k = 0; k < count; k++) {
+        uint32_t id = client_id * 100 + k;
+        DaemonRequest req = make_request(id, 1 + gen.below(6), gen.below(60), k % 2 ? CriterionK1 : CriterionK2);
+        std::vector<int> times = random_times(gen, req.N);
+        if (!daemon_send_request(sock, req, times.data())) fail("send " + std::to_string(id));
+        sent[id] = {req, times};
+    }
+    for (int k = 0; k < count; k++) {
+        DaemonReply reply;
+        std::vector<int> compact;
+        if (!daemon_recv_reply(sock, reply, compact)) {
+            fail("client " + std::to_string(client_id) + " lost the connection");
+            break;
+        }
+        auto it = sent.find(reply.id);
+        if (it == sent.end()) {
+            fail("unexpected reply id " + std::to_string(reply.id));
+            continue;
+        }
+        check_reply(it->second.first, it->second.second, reply, compact);
+        sent.erase(it);
+    }
+    close(sock);
+}
+
+// Сервер закрыл соединение: чтение возвращает конец потока.
+bool closed_by_server(int sock) {
+    char c;
+    return read(sock, &c, 1) <= 0;
+}
+
+void check_bad_frames(const std::string& path) {
+    Rng gen(99);
+    int sock = connect_to(path);
+    if (sock < 0) return fail("bad frames: cannot connect");
+    DaemonReply reply;
+    std::vector<int> compact;
+
+    // Неизвестный критерий отклоняется, но соединение продолжает принимать запросы.
+    std::vector<int> times = random_times(gen, 20);
+    daemon_send_request(sock, make_request(1, 3, 20, 7), times.data());
+    if (!daemon_recv_reply(sock, reply, compact) || reply.id != 1 || reply.status != DaemonUnsupportedCriterion)
+        fail("bad criterion: expected DaemonUnsupportedCriterion");
+    DaemonRequest ok = make_request(2, 3, 20, CriterionK1);
+    daemon_send_request(sock, ok, times.data());
+    if (!daemon_recv_reply(sock, reply, compact) || reply.id != 2) fail("request after a bad criterion got no reply");
+    else check_reply(ok, times, reply, compact);
+
+    // Плохой заголовок: ответ DaemonBadRequest, затем сервер закрывает соединение.
+    DaemonRequest bad = make_request(3, 0, 20, CriterionK2);
+    daemon_send_request(sock, bad, times.data());
+    if (!daemon_recv_reply(sock, reply, compact) || reply.id != 3 || reply.status != DaemonBadRequest)
+        fail("M = 0: expected DaemonBadRequest");
+    if (!closed_by_server(sock)) fail("M = 0: connection stays open");
+    close(sock);
+
+    sock = connect_to(path);
+    bad = make_request(4, 3, 20, CriterionK2);
+    bad.magic = 0;
+    write_all(sock, &bad, sizeof(bad));
+    if (!daemon_recv_reply(sock, reply, compact) || reply.status != DaemonBadRequest)
+        fail("bad magic: expected DaemonBadRequest");
+    if (!closed_by_server(sock)) fail("bad magic: connection stays open");
+    close(sock);
+
+    // Обрезанный кадр: длительностей меньше N, клиент закрывает запись — ответа нет.
+    sock = connect_to(path);
+    DaemonRequest cut = make_request(5, 3, 20, CriterionK2);
+    write_all(sock, &cut, sizeof(cut));
+    write_all(sock, times.data(), 5 * sizeof(int));
+    shutdown(sock, SHUT_WR);
+    if (!closed_by_server(sock)) fail("truncated frame: got a reply");
+    close(sock);
+}
+
+int main(int argc, char** argv) {
+    std::string program = argc > 1 ? argv[1] : "./main";
+    std::string path = "/tmp/sa_daemon_check." + std::to_string(getpid()) + ".sock";
+    pid_t pid = fork();
+    if (pid == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        execl(program.c_str(), program.c_str(), "4", "1", "L", "--daemon", path.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    int probe = -1;
+    for (int attempt = 0; attempt < 100 && probe < 0; attempt++) {
+        probe = connect_to(path);
+        if (probe < 0) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    if (probe < 0) {
+        std::cerr << "FAIL daemon " << program << " did not start on " << path << "\n";
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        return 1;
+    }
+
+    std::vector<std::thread> clients;
+    for (int c = 0; c < 6; c++) clients.emplace_back(client, path, c, 8);
+    for (std::thread& t : clients) t.join();
+    check_bad_frames(path);
+
+    // SIGINT при открытом простаивающем соединении probe.
+    kill(pid, SIGINT);
+    int status = 0;
+    bool exited = false;
+    for (int attempt = 0; attempt < 100 && !exited; attempt++) {
+        exited = waitpid(pid, &status, WNOHANG) == pid;
+        if (!exited) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    if (!exited) {
+        fail("SIGINT: daemon still running after 5 s");
+        kill(pid, SIGKILL);
+        waitpid(pid, &status, 0);
+    } else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fail("SIGINT: daemon exit status " + std::to_string(status));
+    }
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) fail("SIGINT: socket file left behind");
+    if (!closed_by_server(probe)) fail("SIGINT: idle connection stays open");
+    close(probe);
+
+    if (failures) {
+        std::cerr << failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << "OK\n";
+    return 0;
+}
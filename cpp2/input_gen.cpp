@@ -1,29 +1,33 @@
-#include <fstream>
 #include <random>
 #include <iostream>
+#include <string>
+#include <vector>
+#include "rng.h"
+#include "jobfile.h"
 
 int main(int argc, char* argv[]) {
-    if (argc != 4) {
-        std::cout << "Usage: ./gen <Jobs> <minTime> <maxTime>\n";
+    if (argc < 4 || argc > 6) {
+        std::cout << "Usage: ./gen <Jobs> <minTime> <maxTime> [seed] [out file: jobs.csv | *.bin]\n";
         return 1;
     }
 
     int N = std::atoi(argv[1]);
     int minT = std::atoi(argv[2]);
     int maxT = std::atoi(argv[3]);
-    std::mt19937 gen(time(nullptr));
-    std::uniform_int_distribution<> dist(minT, maxT);
+    // С заданным зерном набор работ воспроизводится побитово на любой платформе.
+    Rng gen(argc >= 5 ? std::strtoull(argv[4], nullptr, 10) : std::random_device()());
 
     std::vector<int> jobDurations;
     for (int i = 0; i < N; ++i) {
-        jobDurations.push_back(dist(gen));
+        jobDurations.push_back(minT + gen.below(maxT - minT + 1));
         //std::cout << i << " - job, duration: " << jobDurations[i] << "\n";
     }
 
-    std::ofstream out("jobs.csv");
-    out << "JobID,Duration\n";
-    for(int i=0; i<N; ++i)
-        out << i << "," << jobDurations[i] << "\n";
-    out.close();
+    // Файл с расширением .bin пишется в двоичном формате, иначе в CSV.
+    std::string path = argc == 6 ? argv[5] : "jobs.csv";
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0)
+        save_jobs_binary(path.c_str(), jobDurations);
+    else
+        save_jobs_csv(path.c_str(), jobDurations);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#ifndef JOBFILE_H
+#define JOBFILE_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "schedule.h"
+
+// Файл работ бывает двух видов, формат определяется по первым байтам:
+//  - CSV: строка заголовка "JobID,Duration", затем строки "номер,длительность";
+//  - двоичный: JobFileHeader, затем count длительностей uint32 подряд. Длительности не превышают
+//    INT_MAX, поэтому массив отображается в память и используется как таблица работ без разбора.
+
+struct JobFileHeader {
+    char magic[8];
+    uint32_t count;
+    uint32_t reserved;
+};
+
+const char JOBFILE_MAGIC[8] = {'S', 'A', 'J', 'O', 'B', 'S', '1', '\0'};
+
+// Отображение файла только для чтения; освобождается вместе с последней копией указателя.
+inline std::shared_ptr<const char> map_file(const char* path, size_t& size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error(std::string("Ошибка открытия файла ") + path);
+    struct stat st;
+    fstat(fd, &st);
+    size = st.st_size;
+    if (size == 0) {
+        close(fd);
+        return std::shared_ptr<const char>(new char[1](), std::default_delete<char[]>());
+    }
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        throw std::runtime_error(std::string("Ошибка отображения файла ") + path);
+    madvise(addr, size, MADV_SEQUENTIAL);
+    return std::shared_ptr<const char>(static_cast<const char*>(addr),
+                                       [size](const char* p) { munmap(const_cast<char*>(p), size); });
+}
+
+// Разбирает CSV прямо из отображения: std::from_chars, без промежуточных строк и потоков.
+// Строки без запятой пропускаются, как и раньше.
+inline std::vector<int> parse_jobs_csv(const char* p, const char* end) {
+    std::vector<int> times;
+    times.reserve((end - p) / 6);
+    p = std::find(p, end, '\n');  // заголовок
+    while (p < end) {
+        const char* eol = std::find(++p, end, '\n');
+        const char* comma = std::find(p, eol, ',');
+        if (comma < eol) {
+            const char* q = comma + 1;
+            while (q < eol && *q == ' ') q++;
+            int duration;
+            if (std::from_chars(q, eol, duration).ec == std::errc())
+                times.push_back(duration);
+        }
+        p = eol;
+    }
+    return times;
+}
+
+// Загружает таблицу работ из файла любого из двух форматов.
+inline JobTable load_jobs(const char* path) {
+    size_t size;
+    std::shared_ptr<const char> data = map_file(path, size);
+    if (size >= sizeof(JobFileHeader) && std::memcmp(data.get(), JOBFILE_MAGIC, sizeof(JOBFILE_MAGIC)) == 0) {
+        JobFileHeader hdr;
+        std::memcpy(&hdr, data.get(), sizeof(hdr));
+        if (size < sizeof(hdr) + size_t(hdr.count) * sizeof(uint32_t))
+            throw std::runtime_error(std::string("Файл работ обрезан: ") + path);
+        const int* times = reinterpret_cast<const int*>(data.get() + sizeof(hdr));
+        return JobTable{times, (int)hdr.count, data};
+    }
+    return JobTable::fromVector(parse_jobs_csv(data.get(), data.get() + size));
+}
+
+inline void save_jobs_csv(const char* path, const std::vector<int>& times) {
+    std::ofstream out(path);
+    out << "JobID,Duration\n";
+    for (size_t i = 0; i < times.size(); ++i)
+        out << i << "," << times[i] << "\n";
+}
+
+inline void save_jobs_binary(const char* path, const std::vector<int>& times) {
+    JobFileHeader hdr = {};
+    std::memcpy(hdr.magic, JOBFILE_MAGIC, sizeof(JOBFILE_MAGIC));
+    hdr.count = times.size();
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    out.write(reinterpret_cast<const char*>(times.data()), times.size() * sizeof(int));
+}
+
+#endif
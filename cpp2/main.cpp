@@ -1,243 +1,773 @@
 #include <iostream>
-#include <random>
 #include <algorithm>
+#include <cstring>
 #include <fstream>
-#include <ctime>
 #include <sstream>
-#include <cstring>
+#include <atomic>
+#include <barrier>
+#include <thread>
+#include <random>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <sys/un.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include "annealing.h"
+#include "schedule.h"
+#include "transport.h"
+#include "telemetry.h"
+#include "rng.h"
+#include "jobfile.h"
+#include "mutations.h"
+#include "stats.h"
+#include "daemon.h"
+#include "tempering.h"
+#include "checkpoint.h"
 
 const char *SOCKET_PATH = "/tmp/sasocket";
 
-class Solution {
-public:
-    virtual void applyMutation(class MutationOperator&) = 0;
-    virtual double getCost() const = 0;
-    virtual Solution* clone() const = 0;
-    virtual ~Solution() {}
+// Политика миграции в асинхронном режиме: что получает рабочий, сдавший решение.
+enum class Migration {
+    Best,    // текущее глобально лучшее решение
+    Ring,    // лучшее из своего решения и последнего решения соседа по кольцу
+    Random   // лучшее из своего решения и последнего решения случайного рабочего
 };
 
-class MutationOperator {
-public:
-    virtual void mutate(Solution& sol) = 0;
-    virtual ~MutationOperator() {}
+// Начальное расписание ИО.
+enum class InitRule {
+    Random,  // случайная перестановка, раздача по кругу
+    SPT,     // Schedule::spt, оптимум K2
+    LPT      // Schedule::lpt
 };
 
-class CoolingSchedule {
-public:
-    virtual double getNextTemperature(double currTemp, int iter) const = 0;
-    virtual ~CoolingSchedule() {}
+// Параметры запуска из командной строки.
+struct Options {
+    int Nproc = 1;
+    int M = 1;
+    bool useThreads = false;
+    bool useSocket = false;
+    bool useAsync = false;
+    Migration migration = Migration::Best;
+    int stall = 10;
+    TelemetryConfig telemetry;
+    // Зерно запуска: мастер берёт поток 0, мутации рабочего id — поток id + 1,
+    // его правило Метрополиса — поток Nproc + 1 + id.
+    uint64_t seed = 0;
+    std::string jobsPath = "jobs.csv";  // CSV или двоичный файл, формат определяется по содержимому
+    InitRule init = InitRule::Random;
+    Criterion criterion = Criterion::K2;
+    bool constructOnly = false;  // только построить начальное расписание, без ИО
+    unsigned mutations = 1u << PortfolioMutation::Swap;  // операторы мутации (PortfolioMutation::parseMask)
+    int tries = MultiSwapMutation::DEFAULT_TRIES;  // кандидатов за шаг у оператора multiswap
+    bool opStats = false;  // печатать статистику операторов каждого рабочего в stderr
+    std::string statsPath;    // JSON со счётчиками и временем фаз при выходе
+    std::string statsSocket;  // сокет живой статистики
+    std::string daemonPath;   // сокет резидентного решателя; пусто — обычный запуск
+    // Обмен репликами: Nproc потоков на лестнице температур от ladderMax до ladderMin,
+    // обмен соседей каждые exchangeSteps итераций, останов после stall обменов без улучшения.
+    bool tempering = false;
+    double ladderMin = 1.0;
+    double ladderMax = 100.0;
+    long long exchangeSteps = 1000;
+    // Контрольные точки (только --threads и --tempering): файл, период в секундах, продолжение.
+    std::string checkpointPath;
+    double checkpointEvery = 60;
+    bool resume = false;
 };
 
-class BoltzmannCooling : public CoolingSchedule {
-public:
-    double getNextTemperature(double currTemp, int iter) const override {
-        return currTemp / std::log(1 + iter);
+Schedule make_initial(const Options& opts, const JobTable& jobs, Rng& gen) {
+    switch (opts.init) {
+    case InitRule::SPT: return Schedule::spt(opts.M, jobs);
+    case InitRule::LPT: return Schedule::lpt(opts.M, jobs);
+    default: return Schedule(opts.M, jobs, gen);
     }
-};
+}
+
+// Одна строка на рабочего; stderr, чтобы не мешать разбору "Best K2:" в stdout.
+void print_operator_stats(int id, const PortfolioMutation& mutator) {
+    std::ostringstream out;
+    out << "Worker " << id << ":";
+    for (const OperatorStats& st : mutator.stats())
+        out << " " << st.name << " proposed=" << st.proposed << " accepted=" << st.accepted
+            << " improved=" << st.improved << " score=" << st.score;
+    out << "\n";
+    std::cerr << out.str();
+}
 
-class CauchyCooling : public CoolingSchedule {
-public:
-    double getNextTemperature(double currTemp, int iter) const override {
-        return currTemp / (1 + iter);
+// Дожидается рабочих-процессов, чтобы их последние показатели попали в таблицу, и пишет JSON.
+void finish_stats(StatsBoard& board, const Options& opts) {
+    if (!board.isEnabled()) return;
+    while (wait(nullptr) > 0) {}
+    board.stopLive();
+    if (!opts.statsPath.empty()) {
+        std::ofstream out(opts.statsPath);
+        board.writeJson(out);
     }
-};
+}
 
-class LinearCooling : public CoolingSchedule {
-public:
-    double getNextTemperature(double currTemp, int iter) const override {
-        return currTemp * 0.99;
+// Итог запуска. Для K2 ещё и отклонение от оптимума, который даёт правило SPT;
+// для K1 оптимум неизвестен (задача NP-трудна), печатается только результат.
+void report_best(double best, double optimum, Criterion criterion) {
+    if (criterion == Criterion::K1) {
+        std::cout << "Best K1: " << best << std::endl;
+        return;
     }
-};
+    std::cout << "Best K2: " << best << std::endl;
+    std::cout << "Optimal K2: " << optimum << " Gap: "
+              << (optimum > 0 ? 100.0 * (best - optimum) / optimum : 0.0) << "%" << std::endl;
+}
+
+inline Rng worker_rng(const Options& opts, int id) {
+    return Rng::stream(opts.seed, id + 1);
+}
+
+// Генератор правила Метрополиса рабочего id: поток Nproc + 1 + id, не пересекается с потоками мутаций.
+// Переходит из запуска в запуск ИО через SimulatedAnnealingT::rng(), так что запуски не повторяют чисел.
+inline Rng accept_rng(const Options& opts, int id) {
+    return Rng::stream(opts.seed, opts.Nproc + 1 + id);
+}
+
+// Рабочий процесс: 10 раз запускает ИО и обменивается лучшими решениями с мастером.
+template <class Cool>
+void run_worker(int sock, int id, const Options& opts, StatsBoard& board) {
+    TelemetryWriter telemetry(opts.telemetry);
+    TelemetrySink* log = telemetry.open(id);
+    PortfolioMutation mutator(worker_rng(opts, id), opts.mutations, opts.tries);
+    Rng acceptGen = accept_rng(opts, id);
+    WorkerStats st;
+    PhaseClock clock(board.isEnabled());
+    Schedule start = recv_schedule(sock);
+    st.waitSec += clock.lap();
+    for (int sync_iter = 0; sync_iter < 10; ++sync_iter) {
+        Cool cooler;
+        double startTemp = 100.0;
+        SimulatedAnnealingT<Schedule, PortfolioMutation, Cool> sa(new Schedule(start), &mutator, &cooler, startTemp, log,
+                                                                  acceptGen);
+        sa.run();
+        acceptGen = sa.rng();
+        st.annealSec += clock.lap();
+        st.addRun(sa);
+        Schedule* best = sa.getBest();
+        send_schedule(sock, *best);
+        delete best;
+        st.serializeSec += clock.lap();
+        board.publish(id, st);
+        start = recv_schedule(sock);
+        st.waitSec += clock.lap();
+    }
+    board.publish(id, st);
+    if (opts.opStats) print_operator_stats(id, mutator);
+}
 
-struct Job { int id; int duration; };
-
-class Schedule: public Solution {
-public:
-    int N, M;
-    std::vector<std::vector<int>> processors;
-    std::vector<int> jobTimes;
-
-    Schedule(int M, const std::vector<int>& times, const std::vector<std::vector<int>>& processors)
-    : M(M), N(times.size()), jobTimes(times), processors(processors) {}
-
-    Schedule(int M, const std::vector<int>& times)
-        : N(times.size()), M(M), jobTimes(times) {
-        processors.resize(M);
-        std::vector<int> jobs(N);
-        for(int i=0; i<N; i++) jobs[i]=i;
-        std::shuffle(jobs.begin(), jobs.end(), std::mt19937(time(nullptr)));
-        for(int i=0; i<N; i++)
-            processors[i % M].push_back(jobs[i]);
+// Асинхронный рабочий: после каждого запуска ИО сдаёт лучшее решение и продолжает
+// с тем, что пришлёт мастер, пока не получит команду завершения.
+template <class Cool>
+void run_async_worker(int sock, int id, const Options& opts, StatsBoard& board) {
+    TelemetryWriter telemetry(opts.telemetry);
+    TelemetrySink* log = telemetry.open(id);
+    PortfolioMutation mutator(worker_rng(opts, id), opts.mutations, opts.tries);
+    Rng acceptGen = accept_rng(opts, id);
+    WorkerStats st;
+    PhaseClock clock(board.isEnabled());
+    Schedule start = recv_schedule(sock);
+    st.waitSec += clock.lap();
+    bool more;
+    do {
+        Cool cooler;
+        double startTemp = 100.0;
+        SimulatedAnnealingT<Schedule, PortfolioMutation, Cool> sa(new Schedule(start), &mutator, &cooler, startTemp, log,
+                                                                  acceptGen);
+        sa.run();
+        acceptGen = sa.rng();
+        st.annealSec += clock.lap();
+        st.addRun(sa);
+        Schedule* best = sa.getBest();
+        send_schedule(sock, *best);
+        delete best;
+        st.serializeSec += clock.lap();
+        board.publish(id, st);
+        more = try_recv_schedule(sock, start);
+        st.waitSec += clock.lap();
+    } while (more);
+    board.publish(id, st);
+    if (opts.opStats) print_operator_stats(id, mutator);
+}
+
+// То же через разделяемый сегмент: расписания не пересылаются, а читаются из слотов.
+template <class Cool>
+void run_shm_worker(ShmExchange& shm, int id, const Options& opts, StatsBoard& board) {
+    TelemetryWriter telemetry(opts.telemetry);
+    TelemetrySink* log = telemetry.open(id);
+    PortfolioMutation mutator(worker_rng(opts, id), opts.mutations, opts.tries);
+    Rng acceptGen = accept_rng(opts, id);
+    WorkerStats st;
+    PhaseClock clock(board.isEnabled());
+    Schedule start(opts.M, shm.jobTable(), std::vector<std::vector<int>>(opts.M));
+    for (int sync_iter = 0; sync_iter < 10; ++sync_iter) {
+        shm.awaitPublished(sync_iter + 1, start);
+        st.waitSec += clock.lap();
+        Cool cooler;
+        double startTemp = 100.0;
+        SimulatedAnnealingT<Schedule, PortfolioMutation, Cool> sa(new Schedule(start), &mutator, &cooler, startTemp, log,
+                                                                  acceptGen);
+        sa.run();
+        acceptGen = sa.rng();
+        st.annealSec += clock.lap();
+        st.addRun(sa);
+        Schedule* best = sa.getBest();
+        shm.submit(id, sync_iter, *best);
+        delete best;
+        st.serializeSec += clock.lap();
+        board.publish(id, st);
     }
+    if (opts.opStats) print_operator_stats(id, mutator);
+}
 
-    double getCost() const override {
-        double total = 0.0;
-        for(int proc = 0; proc < M; ++proc) {
-            int currTime = 0;
-            for(int jobIdx : processors[proc]) {
-                currTime += jobTimes[jobIdx];
-                total += currTime;
+// Многопоточный режим: Nproc потоков в общей памяти, таблица работ разделяется только для чтения.
+// Поток оставляет своё лучшее решение в собственном слоте и выдвигает номер слота в глобальный
+// bestSlot через CAS по минимуму стоимости, без блокировок. Раунды синхронизации разделены барьером;
+// после него каждый поток сам копирует победителя, поэтому последовательного сбора у мастера нет.
+template <class Cool>
+double run_threads(const Schedule& initial, const Options& opts, StatsBoard& board, Checkpointer& ckpt) {
+    int Nproc = opts.Nproc;
+    TelemetryWriter telemetry(opts.telemetry);
+    std::vector<Schedule*> slots(Nproc, nullptr);
+    std::vector<double> costs(Nproc);
+    std::vector<PortfolioMutation*> mutators(Nproc);
+    std::vector<Rng*> acceptGens(Nproc);
+    std::vector<WorkerStats*> workerStats(Nproc);
+    std::atomic<int> bestSlot(-1);
+    int winner = -1;
+    double globalBest = initial.getCost();
+    int round = 0;
+    if (ckpt.resumed) {
+        round = ckpt.resumed->header.round;
+        globalBest = ckpt.resumed->header.globalBest;
+    }
+    const int firstRound = round;
+    // Завершение фазы барьера — редукция мастера; у потоков нет отдельного ожидания мастера.
+    std::barrier sync(Nproc, [&]() noexcept {
+        PhaseClock clock(board.isEnabled());
+        int w = bestSlot.exchange(-1);
+        if (w >= 0) {
+            winner = w;
+            globalBest = costs[w];
+            round++;
+            // Все потоки стоят на барьере: победитель раунда — старт следующего. Каждый раунд ИО
+            // начинается заново со startTemp, так что кроме стартового расписания и генераторов
+            // продолжать нечего; счётчики рабочих и температура в конце раунда сохраняются для статистики.
+            // Число раундов фиксировано, счётчика раундов без улучшения в этом режиме нет.
+            if (ckpt.due()) {
+                Checkpoint c(CheckpointMode::Threads, initial.table, initial.M, opts.seed);
+                c.header.round = round;
+                c.header.globalBest = globalBest;
+                for (int k = 0; k < Nproc; k++) {
+                    const WorkerStats& ws = *workerStats[k];
+                    c.replicas.push_back(ReplicaRecord{ws.finalTemp, ws.iterations, ws.accepted, ws.improved,
+                                                       *acceptGens[k], mutators[k]->saveState()});
+                }
+                c.addSchedule(*slots[w]);
+                ckpt.save(c);
             }
+            board.addRound(0, clock.lap(), globalBest);
         }
-        return total;
-    }
+    });
 
-    void applyMutation(MutationOperator& mut) override {
-        mut.mutate(*this);
+    auto body = [&](int id) {
+        Schedule start(initial);
+        TelemetrySink* log = telemetry.open(id);
+        PortfolioMutation mutator(worker_rng(opts, id), opts.mutations, opts.tries);
+        Rng acceptGen = accept_rng(opts, id);
+        WorkerStats st;
+        if (ckpt.resumed) {
+            const ReplicaRecord& rec = ckpt.resumed->replicas[id];
+            mutator.restoreState(rec.mutator);
+            acceptGen = rec.accept;
+            st.runs = firstRound;
+            st.finalTemp = rec.temp;
+            st.iterations = rec.iterations;
+            st.accepted = rec.accepted;
+            st.improved = rec.improved;
+        }
+        mutators[id] = &mutator;
+        acceptGens[id] = &acceptGen;
+        workerStats[id] = &st;
+        if (ckpt.resumed) board.publish(id, st);
+        PhaseClock clock(board.isEnabled());
+        for (int sync_iter = firstRound; sync_iter < 10; ++sync_iter) {
+            Cool cooler;
+            double startTemp = 100.0;
+            SimulatedAnnealingT<Schedule, PortfolioMutation, Cool> sa(new Schedule(start), &mutator, &cooler, startTemp,
+                                                                      log, acceptGen);
+            sa.run();
+            acceptGen = sa.rng();
+            st.annealSec += clock.lap();
+            st.addRun(sa);
+            Schedule* best = sa.getBest();
+            slots[id] = best;
+            costs[id] = best->getCost();
+            int cur = bestSlot.load(std::memory_order_acquire);
+            // При равных стоимостях побеждает меньший номер, чтобы исход не зависел от порядка потоков.
+            while ((cur < 0 || costs[id] < costs[cur] || (costs[id] == costs[cur] && id < cur)) &&
+                   !bestSlot.compare_exchange_weak(cur, id, std::memory_order_acq_rel)) {}
+            sync.arrive_and_wait();
+            st.waitSec += clock.lap();
+            start.copyFrom(*slots[winner]);
+            st.serializeSec += clock.lap();
+            // Слот победителя нельзя освобождать, пока его копируют остальные потоки.
+            sync.arrive_and_wait();
+            delete best;
+            st.waitSec += clock.lap();
+            board.publish(id, st);
+        }
+        if (opts.opStats) print_operator_stats(id, mutator);
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < Nproc; i++)
+        threads.emplace_back(body, i);
+    for (std::thread& t : threads)
+        t.join();
+    return globalBest;
+}
+
+// Обмен репликами в общей памяти: поток id — реплика на ступени id лестницы температур.
+// Между отрезками по exchangeSteps итераций потоки встают на барьер, и его завершение
+// проводит волну обменов соседних состояний и обновляет глобальный рекорд.
+double run_tempering(const Schedule& initial, const Options& opts, StatsBoard& board, Rng& gen, Checkpointer& ckpt) {
+    using Replica = SimulatedAnnealingT<Schedule, PortfolioMutation, FixedTemperature>;
+    int Nproc = opts.Nproc;
+    TelemetryWriter telemetry(opts.telemetry);
+    TemperatureLadder ladder(Nproc, opts.ladderMin, opts.ladderMax);
+    std::vector<Schedule*> states(Nproc, nullptr);
+    std::vector<double> bestCosts(Nproc);
+    // Состояние потоков для контрольной точки; читается только на барьере.
+    std::vector<Replica*> replicas(Nproc);
+    std::vector<PortfolioMutation*> mutators(Nproc);
+    double globalBest = initial.getCost();
+    int round = 0, noImprove = 0;
+    if (ckpt.resumed) {
+        const CheckpointHeader& h = ckpt.resumed->header;
+        round = h.round;
+        noImprove = h.noImprove;
+        globalBest = h.globalBest;
+        gen = h.master;
     }
-    Solution* clone() const override { return new Schedule(*this); }
-    void print() const {
-        for(int p = 0; p < M; ++p) {
-            std::cout << "Process " << p << ": ";
-            int t = 0;
-            for(int job: processors[p]) {
-                t += jobTimes[job];
-                std::cout << "(job="<< job << " Time=" << t << ") ";
+    bool started = false, done = false;
+    std::barrier sync(Nproc, [&]() noexcept {
+        // Первый проход барьера только публикует states; раунд обменов он не засчитывает.
+        if (!started) {
+            started = true;
+            return;
+        }
+        PhaseClock clock(board.isEnabled());
+        double roundBest = *std::min_element(bestCosts.begin(), bestCosts.end());
+        if (roundBest < globalBest) {
+            globalBest = roundBest;
+            noImprove = 0;
+        } else {
+            noImprove++;
+        }
+        done = noImprove >= opts.stall;
+        ladder.exchange(states, round++, gen);
+        if (!done && ckpt.due()) {
+            Checkpoint c(CheckpointMode::Tempering, initial.table, initial.M, opts.seed);
+            c.header.round = round;
+            c.header.noImprove = noImprove;
+            c.header.globalBest = globalBest;
+            c.header.master = gen;
+            for (int k = 0; k < Nproc; k++) {
+                const Replica& r = *replicas[k];
+                c.replicas.push_back(ReplicaRecord{r.getTemperature(), r.getIterations(), r.getAccepted(),
+                                                   r.getImproved(), r.rng(), mutators[k]->saveState()});
+                c.addSchedule(*states[k]);
+                c.addSchedule(*r.getBest());
             }
-            std::cout << "\n";
+            ckpt.save(c);
+        }
+        board.addRound(0, clock.lap(), globalBest);
+    });
+
+    auto body = [&](int id) {
+        TelemetrySink* log = telemetry.open(id);
+        PortfolioMutation mutator(worker_rng(opts, id), opts.mutations, opts.tries);
+        const ReplicaRecord* rec = ckpt.resumed ? &ckpt.resumed->replicas[id] : nullptr;
+        FixedTemperature fixed;
+        Replica sa(new Schedule(initial), &mutator, &fixed, ladder.temps[id], log,
+                   rec ? rec->accept : accept_rng(opts, id));
+        if (rec) {
+            sa.getCurrent().copyFrom(ckpt.resumed->schedule(2 * id, initial.table));
+            sa.getBest()->copyFrom(ckpt.resumed->schedule(2 * id + 1, initial.table));
+            sa.restoreProgress(rec->temp, rec->iterations, rec->accepted, rec->improved);
+            mutator.restoreState(rec->mutator);
         }
+        states[id] = &sa.getCurrent();
+        replicas[id] = &sa;
+        mutators[id] = &mutator;
+        WorkerStats st;
+        PhaseClock clock(board.isEnabled());
+        sync.arrive_and_wait();
+        while (!done) {
+            sa.sweep(opts.exchangeSteps);
+            bestCosts[id] = sa.getBest()->getCost();
+            st.annealSec += clock.lap();
+            sync.arrive_and_wait();
+            st.waitSec += clock.lap();
+        }
+        st.addRun(sa);
+        board.publish(id, st);
+        delete sa.getBest();
+        if (opts.opStats) print_operator_stats(id, mutator);
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < Nproc; i++)
+        threads.emplace_back(body, i);
+    for (std::thread& t : threads)
+        t.join();
+    if (opts.opStats) {
+        std::ostringstream out;
+        out << "Ladder:";
+        for (int k = 0; k < ladder.size(); k++) out << " T" << k << "=" << ladder.temps[k];
+        out << "\nExchanges:";
+        for (size_t k = 0; k < ladder.attempts.size(); k++)
+            out << " " << k << "-" << k + 1 << "=" << ladder.swaps[k] << "/" << ladder.attempts[k];
+        std::cerr << out.str() << "\n";
     }
+    return globalBest;
+}
 
-    void swapJobsRandom() {
-        if (M < 2) return;
-        std::mt19937 gen(time(nullptr) + rand());
-        int p1 = gen() % M, p2 = gen() % M;
-        while (p2 == p1) p2 = gen() % M;
-        if (processors[p1].empty() || processors[p2].empty()) return;
-        int i1 = gen() % processors[p1].size();
-        int i2 = gen() % processors[p2].size();
-        std::swap(processors[p1][i1], processors[p2][i2]);
+// Задача резидентного решателя: budget запусков ИО подряд, каждый с лучшего расписания.
+// Решается одним потоком пула; параллельность даёт число одновременно решаемых задач.
+template <class Cool>
+Schedule solve_instance(const DaemonRequest& req, const JobTable& jobs, const Options& opts) {
+    Options instance = opts;
+    instance.M = req.M;
+    Rng gen = Rng::stream(req.seed, 0);
+    Schedule best = make_initial(instance, jobs, gen);
+    PortfolioMutation mutator(Rng::stream(req.seed, 1), opts.mutations, opts.tries);
+    Rng acceptGen = Rng::stream(req.seed, 2);
+    for (int run = 0; run < req.budget; ++run) {
+        Cool cooler;
+        double startTemp = 100.0;
+        SimulatedAnnealingT<Schedule, PortfolioMutation, Cool> sa(new Schedule(best), &mutator, &cooler, startTemp, nullptr,
+                                                                  acceptGen);
+        sa.run();
+        acceptGen = sa.rng();
+        Schedule* found = sa.getBest();
+        best.copyFrom(*found);
+        delete found;
     }
+    return best;
+}
+
+// Закон охлаждения выбирается один раз при запуске, дальше работает специализированный цикл ИО.
+struct CoolingEntry {
+    char key;
+    const char* name;
+    void (*worker)(int sock, int id, const Options& opts, StatsBoard& board);
+    void (*asyncWorker)(int sock, int id, const Options& opts, StatsBoard& board);
+    void (*shmWorker)(ShmExchange& shm, int id, const Options& opts, StatsBoard& board);
+    double (*threads)(const Schedule& initial, const Options& opts, StatsBoard& board, Checkpointer& ckpt);
+    Schedule (*solve)(const DaemonRequest& req, const JobTable& jobs, const Options& opts);
 };
 
-class SwapMutation : public MutationOperator {
-public:
-    void mutate(Solution& s) override {
-        auto& sch = dynamic_cast<Schedule&>(s);
-        sch.swapJobsRandom();
-    }
+const CoolingEntry COOLINGS[] = {
+    {'L', "Linear cooling", run_worker<LinearCooling>, run_async_worker<LinearCooling>, run_shm_worker<LinearCooling>, run_threads<LinearCooling>, solve_instance<LinearCooling>},
+    {'B', "Boltzmann cooling", run_worker<BoltzmannCooling>, run_async_worker<BoltzmannCooling>, run_shm_worker<BoltzmannCooling>, run_threads<BoltzmannCooling>, solve_instance<BoltzmannCooling>},
+    {'C', "Cauchy cooling", run_worker<CauchyCooling>, run_async_worker<CauchyCooling>, run_shm_worker<CauchyCooling>, run_threads<CauchyCooling>, solve_instance<CauchyCooling>},
 };
 
-class SimulatedAnnealing {
-    Solution* current;
-    Solution* best;
-    MutationOperator* mutator;
-    CoolingSchedule* cooler;
-    double temp;
-    int maxNoImprove;
-    std::ofstream logFile;
-public:
-    SimulatedAnnealing(Solution* initial, MutationOperator* m, CoolingSchedule* c, double startTemp)
-        : current(initial), best(initial->clone()), mutator(m), cooler(c), temp(startTemp), maxNoImprove(100), logFile("sa_log.csv") {
-        logFile << "Iteration,Temperature,CurrentCost,BestCost\n";
+// Асинхронная островная модель: мастер ждёт сокеты рабочих через epoll и отвечает каждому
+// сразу, как только тот закончил очередной запуск ИО, не дожидаясь остальных.
+// Раунд — Nproc сданных решений; останов после stall раундов без улучшения глобального решения.
+double run_async_master(const std::vector<int>& conns, const Schedule& initial, Migration migration, int stall, Rng& gen,
+                        StatsBoard& board) {
+    int Nproc = conns.size();
+    int ep = epoll_create1(0);
+    for (int i = 0; i < Nproc; i++) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u32 = i;
+        epoll_ctl(ep, EPOLL_CTL_ADD, conns[i], &ev);
+        send_schedule(conns[i], initial);
     }
 
-    void run() {
-        int iter = 0, noImprove = 0;
-        while (noImprove < maxNoImprove) {
-            Solution* candidate = current->clone();
-            //std::cout << "До мутации:\n";
-            //dynamic_cast<Schedule*>(candidate)->print();
-            mutator->mutate(*candidate);
-            //std::cout << "После мутации:\n";
-            //dynamic_cast<Schedule*>(candidate)->print();
-            double dF = candidate->getCost() - current->getCost();
-            if (dF <= 0 || exp(-dF/temp) > 0) {
-                delete current;
-                current = candidate;
-                if (current->getCost() < best->getCost()) {
-                    delete best;
-                    best = current->clone();
-                    noImprove = 0;
-                } else {
-                    noImprove++;
-                }
+    std::vector<Schedule> latest(Nproc, initial);
+    Schedule globalBest = initial;
+    long long noImprove = 0;
+    int active = Nproc;
+    std::vector<epoll_event> events(Nproc);
+    PhaseClock clock(board.isEnabled());
+    double waitSec = 0, reduceSec = 0;
+    long long received = 0;
+    while (active > 0) {
+        int n = epoll_wait(ep, events.data(), Nproc, -1);
+        for (int e = 0; e < n; e++) {
+            int i = events[e].data.u32;
+            bool ok = try_recv_schedule(conns[i], latest[i]);
+            waitSec += clock.lap();
+            if (!ok) {
+                epoll_ctl(ep, EPOLL_CTL_DEL, conns[i], nullptr);
+                active--;
+                continue;
+            }
+            if (latest[i].cost < globalBest.cost) {
+                globalBest = latest[i];
+                noImprove = 0;
             } else {
-                delete candidate;
                 noImprove++;
             }
-            logFile << iter << "," << temp << "," << current->getCost() << "," << best->getCost() << "\n";
-            temp = cooler->getNextTemperature(temp, iter);
-            iter++;
+            if (noImprove >= (long long)stall * Nproc) {
+                send_stop(conns[i]);
+                epoll_ctl(ep, EPOLL_CTL_DEL, conns[i], nullptr);
+                active--;
+                continue;
+            }
+            const Schedule* migrant = &globalBest;
+            if (migration != Migration::Best) {
+                int j = migration == Migration::Ring ? (i + Nproc - 1) % Nproc : gen.below(Nproc);
+                migrant = latest[j].cost < latest[i].cost ? &latest[j] : &latest[i];
+            }
+            send_schedule(conns[i], *migrant);
+            reduceSec += clock.lap();
+            if (++received % Nproc == 0) {
+                board.addRound(waitSec, reduceSec, globalBest.getCost());
+                waitSec = reduceSec = 0;
+            }
         }
     }
-    Solution* getBest() const { return best; }
-};
-
-void send_schedule(int sock, const Schedule &s) {
-    int M = s.processors.size();
-    write(sock, &M, sizeof(M));
-    int N = s.jobTimes.size();
-    write(sock, &N, sizeof(N));
-    write(sock, s.jobTimes.data(), N * sizeof(int));
-    for(int i=0; i<M; i++) {
-        int nJobs = s.processors[i].size();
-        write(sock, &nJobs, sizeof(nJobs));
-        write(sock, s.processors[i].data(), nJobs * sizeof(int));
-    }
+    close(ep);
+    return globalBest.getCost();
 }
 
-Schedule recv_schedule(int sock) {
-    int M, N;
-    read(sock, &M, sizeof(M));
-    read(sock, &N, sizeof(N));
-    std::vector<int> jobTimes(N);
-    read(sock, jobTimes.data(), N * sizeof(int));
-    std::vector<std::vector<int>> processors(M);
-    for(int i=0; i<M; i++) {
-        int nJobs;
-        read(sock, &nJobs, sizeof(nJobs));
-        processors[i].resize(nJobs);
-        read(sock, processors[i].data(), nJobs * sizeof(int));
+// Разбирает необязательные ключи после позиционных аргументов; false при ошибке.
+bool parse_options(int argc, char* argv[], Options& opts) {
+    for (int i = 4; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threads") {
+            opts.useThreads = true;
+        } else if (arg == "--socket") {
+            opts.useSocket = true;
+        } else if (arg == "--async") {
+            opts.useAsync = opts.useSocket = true;
+        } else if (arg == "--migration" && hasValue) {
+            std::string m = argv[++i];
+            if (m == "best") opts.migration = Migration::Best;
+            else if (m == "ring") opts.migration = Migration::Ring;
+            else if (m == "random") opts.migration = Migration::Random;
+            else {
+                std::cout << "ERROR: Bad migration policy " << m << "\n";
+                return false;
+            }
+        } else if (arg == "--stall" && hasValue) {
+            opts.stall = std::atoi(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            opts.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--jobs" && hasValue) {
+            opts.jobsPath = argv[++i];
+        } else if (arg == "--init" && hasValue) {
+            std::string m = argv[++i];
+            if (m == "random") opts.init = InitRule::Random;
+            else if (m == "spt") opts.init = InitRule::SPT;
+            else if (m == "lpt") opts.init = InitRule::LPT;
+            else {
+                std::cout << "ERROR: Bad initial rule " << m << "\n";
+                return false;
+            }
+        } else if (arg == "--criterion" && hasValue) {
+            std::string m = argv[++i];
+            if (m == "K2") opts.criterion = Criterion::K2;
+            else if (m == "K1") opts.criterion = Criterion::K1;
+            else {
+                std::cout << "ERROR: Bad criterion " << m << "\n";
+                return false;
+            }
+        } else if (arg == "--construct") {
+            opts.constructOnly = true;
+        } else if (arg == "--mutation" && hasValue) {
+            opts.mutations = PortfolioMutation::parseMask(argv[++i]);
+            if (!opts.mutations) {
+                std::cout << "ERROR: Bad mutation list " << argv[i] << "\n";
+                return false;
+            }
+        } else if (arg == "--tries" && hasValue) {
+            opts.tries = std::atoi(argv[++i]);
+            if (opts.tries < 1 || opts.tries > MultiSwapMutation::MAX_TRIES) {
+                std::cout << "ERROR: --tries must be in 1.." << MultiSwapMutation::MAX_TRIES << "\n";
+                return false;
+            }
+        } else if (arg == "--op-stats") {
+            opts.opStats = true;
+        } else if (arg == "--stats" && hasValue) {
+            opts.statsPath = argv[++i];
+        } else if (arg == "--stats-socket" && hasValue) {
+            opts.statsSocket = argv[++i];
+        } else if (arg == "--tempering") {
+            opts.tempering = true;
+        } else if (arg == "--ladder" && hasValue) {
+            char* end;
+            opts.ladderMin = std::strtod(argv[++i], &end);
+            opts.ladderMax = *end == ':' ? std::strtod(end + 1, &end) : 0;
+            if (*end || opts.ladderMin <= 0 || opts.ladderMax < opts.ladderMin) {
+                std::cout << "ERROR: Bad ladder " << argv[i] << ", expected TMIN:TMAX\n";
+                return false;
+            }
+        } else if (arg == "--exchange" && hasValue) {
+            opts.exchangeSteps = std::max(1LL, std::atoll(argv[++i]));
+        } else if (arg == "--checkpoint" && hasValue) {
+            opts.checkpointPath = argv[++i];
+        } else if (arg == "--checkpoint-every" && hasValue) {
+            opts.checkpointEvery = std::atof(argv[++i]);
+        } else if (arg == "--resume") {
+            opts.resume = true;
+        } else if (arg == "--daemon" && hasValue) {
+            opts.daemonPath = argv[++i];
+        } else if (arg == "--log" && hasValue) {
+            std::string m = argv[++i];
+            if (m == "off") opts.telemetry.mode = LogMode::Off;
+            else if (m == "worker") opts.telemetry.mode = LogMode::Worker;
+            else if (m == "merged") opts.telemetry.mode = LogMode::Merged;
+            else {
+                std::cout << "ERROR: Bad log mode " << m << "\n";
+                return false;
+            }
+        } else if (arg == "--log-every" && hasValue) {
+            opts.telemetry.every = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cout << "ERROR: Unknown option " << arg << "\n";
+            return false;
+        }
     }
-    return Schedule(M, jobTimes, processors);
+    return true;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 4) {
-        std::cout << "Usage: ./main <Nproc> <M> <cooling: B C L>\n";
+    if (argc < 4) {
+        std::cout << "Usage: ./main <Nproc> <M> <cooling: B C L> [--threads | --socket | --async]\n"
+                  << "       async options: [--migration best|ring|random] [--stall K]\n"
+                  << "       log options: [--log off|worker|merged] [--log-every K]\n"
+                  << "       [--seed S] [--jobs FILE (default jobs.csv)] [--criterion K2|K1 (default K2)]\n"
+                  << "       [--init random|spt|lpt] [--construct: print the initial schedule cost, no SA]\n"
+                  << "       [--mutation portfolio | list of swap,move,reorder,adjacent,multiswap] [--tries K] [--op-stats]\n"
+                  << "       [--stats FILE.json] [--stats-socket PATH]\n"
+                  << "       [--tempering: replica exchange, Nproc threads] [--ladder TMIN:TMAX] [--exchange STEPS]\n"
+                  << "       [--checkpoint FILE] [--checkpoint-every SEC (default 60)] [--resume]: --threads, --tempering\n"
+                  << "       [--daemon PATH: serve solve requests on a UNIX socket with Nproc worker threads]\n";
         return 1;
     }
-    int Nproc = std::atoi(argv[1]);
-    int M = std::atoi(argv[2]);
-    char cooling = argv[3][0];
-    if (cooling == 'L') {
-        std::cout << "Linear cooling\n";
-    } else if (cooling == 'B') {
-        std::cout << "Boltzmann cooling\n";
-    } else if (cooling == 'C') {
-        std::cout << "Cauchy cooling\n";
-    } else {
+    Options opts;
+    opts.seed = std::random_device()();
+    if (!parse_options(argc, argv, opts)) return 1;
+    int Nproc = opts.Nproc = std::atoi(argv[1]);
+    int M = opts.M = std::atoi(argv[2]);
+    const CoolingEntry* cooling = nullptr;
+    for (const CoolingEntry& c : COOLINGS)
+        if (c.key == argv[3][0]) cooling = &c;
+    if (!cooling) {
         std::cout << "ERROR: Bad cooling\n";
         return 1;
     }
-    int N = 0;
-    double startTemp = 100.0;
-    std::vector<int> jobDurations;
-    std::ifstream in("jobs.csv");
-    if (!in.is_open()) {
-        std::cerr << "Ошибка открытия файла jobs.csv" << std::endl;
+    // Точки снимаются только в режимах внутри одного процесса; рабочие shm и сокетного режимов
+    // — отдельные процессы, и их состояние в точку не попадает.
+    bool inProcess = (opts.useThreads || opts.tempering) && opts.daemonPath.empty();
+    if ((!opts.checkpointPath.empty() || opts.resume) && !inProcess) {
+        std::cout << "ERROR: --checkpoint and --resume need --threads or --tempering\n";
         return 1;
     }
+    std::cout << (opts.tempering ? "Parallel tempering" : cooling->name) << std::endl;
+    if (!opts.daemonPath.empty()) {
+        SolverDaemon daemon(Nproc, [&](const DaemonRequest& req, const JobTable& jobs) {
+            return cooling->solve(req, jobs, opts);
+        });
+        try {
+            daemon.serve(opts.daemonPath);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    std::cout << "Seed: " << opts.seed << std::endl;
+    Rng gen = Rng::stream(opts.seed, 0);
+    JobTable jobs;
+    try {
+        jobs = load_jobs(opts.jobsPath.c_str());
+        jobs.criterion = opts.criterion;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    double optimum = Schedule::spt(M, jobs).getCost();
+    if (opts.constructOnly) {
+        report_best(make_initial(opts, jobs, gen).getCost(), optimum, opts.criterion);
+        return 0;
+    }
 
-    std::string line;
-    std::getline(in, line);
-    std::getline(in, line);
-    while (std::getline(in, line)) {
-        std::stringstream s(line);
-        std::string jobIdStr, durationStr;
-        if (std::getline(s, jobIdStr, ',') && std::getline(s, durationStr)) {
-                int duration = std::stoi(durationStr);
-                jobDurations.push_back(duration);
-                N++;
+    Checkpointer ckpt(opts.checkpointPath, opts.checkpointEvery);
+    if (opts.resume) {
+        CheckpointMode mode = opts.tempering ? CheckpointMode::Tempering : CheckpointMode::Threads;
+        try {
+            if (opts.checkpointPath.empty()) throw std::runtime_error("--resume needs --checkpoint FILE");
+            ckpt.resumed = Checkpoint::load(opts.checkpointPath, mode, jobs, M);
+        } catch (const std::exception& e) {
+            std::cout << "ERROR: " << e.what() << "\n";
+            return 1;
+        }
+        if (ckpt.resumed->header.replicas != Nproc) {
+            std::cout << "ERROR: Checkpoint has " << ckpt.resumed->header.replicas << " workers, not " << Nproc << "\n";
+            return 1;
         }
+        std::cout << "Resumed at round " << ckpt.resumed->header.round << std::endl;
+    }
+
+    TelemetryWriter::prepare(opts.telemetry);
+    StatsBoard board(Nproc, !opts.statsPath.empty() || !opts.statsSocket.empty());
+    if (opts.tempering) {
+        Schedule initial = make_initial(opts, jobs, gen);
+        board.serveLive(opts.statsSocket);
+        report_best(run_tempering(initial, opts, board, gen, ckpt), optimum, opts.criterion);
+        finish_stats(board, opts);
+        return 0;
+    }
+    if (opts.useThreads) {
+        Schedule initial = ckpt.resumed ? ckpt.resumed->schedule(0, jobs) : make_initial(opts, jobs, gen);
+        board.serveLive(opts.statsSocket);
+        report_best(cooling->threads(initial, opts, board, ckpt), optimum, opts.criterion);
+        finish_stats(board, opts);
+        return 0;
+    }
+
+    if (!opts.useSocket) {
+        ShmExchange shm(jobs, M, Nproc);
+        for (int i = 0; i < Nproc; i++) {
+            if (fork() == 0) {
+                cooling->shmWorker(shm, i, opts, board);
+                exit(0);
+            }
+        }
+        board.serveLive(opts.statsSocket);
+        Schedule initial = make_initial(opts, shm.jobTable(), gen);
+        shm.store(Nproc, 0, initial);
+        shm.publish(Nproc, 0);
+        PhaseClock clock(board.isEnabled());
+        for (int sync_iter = 0; sync_iter < 10; sync_iter++) {
+            shm.awaitSubmitted(Nproc * (sync_iter + 1));
+            double waitSec = clock.lap();
+            int best = shm.bestWorker(sync_iter);
+            if (sync_iter == 9) {
+                report_best(shm.cost(best, sync_iter % 2), optimum, opts.criterion);
+            }
+            shm.publish(best, sync_iter % 2);
+            board.addRound(waitSec, clock.lap(), shm.cost(best, sync_iter % 2));
+        }
+        finish_stats(board, opts);
+        return 0;
     }
-    in.close();
 
     int listen_sock = socket(AF_UNIX, SOCK_STREAM, 0);
     sockaddr_un addr = {};
@@ -247,7 +777,6 @@ int main(int argc, char* argv[]) {
     bind(listen_sock, (sockaddr*)&addr, sizeof(addr));
     listen(listen_sock, Nproc);
 
-    //auto t0=clock();
     for(int i=0; i < Nproc; i++) {
         if(fork() == 0) {
             int sock = socket(AF_UNIX, SOCK_STREAM, 0);
@@ -255,37 +784,10 @@ int main(int argc, char* argv[]) {
             caddr.sun_family = AF_UNIX;
             strcpy(caddr.sun_path, SOCKET_PATH);
             connect(sock, (sockaddr*)&caddr, sizeof(caddr));
-            Schedule start = recv_schedule(sock);
-
-            for (int sync_iter = 0; sync_iter < 10; ++sync_iter) {
-                SwapMutation mutator;
-                double startTemp = 100.0;
-                if (cooling == 'L') {
-                    LinearCooling cooler;
-                    SimulatedAnnealing sa(new Schedule(start), &mutator, &cooler, startTemp);
-                    sa.run();
-                    Schedule* best = dynamic_cast<Schedule*>(sa.getBest());
-                    send_schedule(sock, *best);
-                    delete best;
-                    start = recv_schedule(sock);
-                } else if (cooling == 'B') {
-                    BoltzmannCooling cooler;
-                    SimulatedAnnealing sa(new Schedule(start), &mutator, &cooler, startTemp);
-                    sa.run();
-                    Schedule* best = dynamic_cast<Schedule*>(sa.getBest());
-                    send_schedule(sock, *best);
-                    delete best;
-                    start = recv_schedule(sock);
-                } else {
-                    CauchyCooling cooler;
-                    SimulatedAnnealing sa(new Schedule(start), &mutator, &cooler, startTemp);
-                    sa.run();
-                    Schedule* best = dynamic_cast<Schedule*>(sa.getBest());
-                    send_schedule(sock, *best);
-                    delete best;
-                    start = recv_schedule(sock);
-                }
-            }
+            if (opts.useAsync)
+                cooling->asyncWorker(sock, i, opts, board);
+            else
+                cooling->worker(sock, i, opts, board);
             close(sock);
             exit(0);
         }
@@ -294,11 +796,21 @@ int main(int argc, char* argv[]) {
     std::vector<int> conns;
     for(int i=0; i < Nproc; i++)
         conns.push_back(accept(listen_sock, NULL, NULL));
+    board.serveLive(opts.statsSocket);
 
-    Schedule initial(M, jobDurations);
+    Schedule initial = make_initial(opts, jobs, gen);
+    if (opts.useAsync) {
+        report_best(run_async_master(conns, initial, opts.migration, opts.stall, gen, board), optimum, opts.criterion);
+        for(int i=0; i < Nproc; i++) close(conns[i]);
+        close(listen_sock);
+        unlink(SOCKET_PATH);
+        finish_stats(board, opts);
+        return 0;
+    }
     for(int i=0; i < Nproc; i++)
         send_schedule(conns[i], initial);
 
+    PhaseClock clock(board.isEnabled());
     for (int sync_iter = 0; sync_iter < 10; sync_iter++) {
         std::vector<Schedule> workerSchedules;
         std::vector<double> costs;
@@ -307,18 +819,19 @@ int main(int argc, char* argv[]) {
             workerSchedules.push_back(ws);
             costs.push_back(ws.getCost());
         }
+        double waitSec = clock.lap();
         int best_idx = std::min_element(costs.begin(), costs.end()) - costs.begin();
         Schedule globalBest = workerSchedules[best_idx];
         //std::cout << "Синхронизация " << sync_iter << " Best K2: " << globalBest.getCost() << std::endl;
         if (sync_iter == 9) {
-            std::cout << "Best K2: " << globalBest.getCost() << std::endl;
+            report_best(globalBest.getCost(), optimum, opts.criterion);
         }
         for(int i=0;i < Nproc;i++) send_schedule(conns[i], globalBest);
+        board.addRound(waitSec, clock.lap(), globalBest.getCost());
     }
     for(int i=0; i < Nproc; i++) close(conns[i]);
     close(listen_sock);
     unlink(SOCKET_PATH);
-    //auto dt=(clock()-t0)/CLOCKS_PER_SEC;
-    //std::cout << "Time:" << dt << "\n";
+    finish_stats(board, opts);
     return 0;
 }
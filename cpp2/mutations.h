@@ -0,0 +1,382 @@
+#ifndef MUTATIONS_H
+#define MUTATIONS_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include "annealing.h"
+#include "schedule.h"
+#include "rng.h"
+
+// Операторы мутации расписания в дополнение к SwapMutation и адаптивный портфель из них.
+// Каждый оператор хранит журнал последнего хода, undo() применяет обратный ход.
+
+// Случайный процессор, на котором не меньше minJobs работ; false, если за несколько попыток не нашёлся.
+inline bool pick_processor(Rng& gen, const Schedule& sch, int minJobs, int& p) {
+    for (int attempt = 0; attempt < 8; attempt++) {
+        p = gen.below(sch.M);
+        if (sch.jobCount(p) >= minJobs) return true;
+    }
+    return false;
+}
+
+// Перенос случайной работы на случайную позицию другого процессора; меняет число работ процессоров.
+class MoveMutation final : public MutationOperator {
+    Rng gen;
+    ShiftMove last;
+    long long lastDelta = 0;
+    bool applied = false;
+public:
+    explicit MoveMutation(const Rng& gen = Rng()) : gen(gen) {}
+    const Rng& rng() const { return gen; }
+
+    void mutate(Solution& s) override { mutate(dynamic_cast<Schedule&>(s)); }
+    void undo(Solution& s) override { undo(dynamic_cast<Schedule&>(s)); }
+
+    void mutate(Schedule& sch) {
+        applied = sch.M >= 2 && pick_processor(gen, sch, 1, last.p1);
+        if (!applied) return;
+        last.p2 = gen.below(sch.M - 1);
+        if (last.p2 >= last.p1) last.p2++;
+        last.i1 = gen.below(sch.jobCount(last.p1));
+        last.i2 = gen.below(sch.jobCount(last.p2) + 1);
+        lastDelta = sch.deltaCost(last);
+        sch.applyMove(last, lastDelta);
+    }
+    void undo(Schedule& sch) {
+        if (!applied) return;
+        sch.applyMove(ShiftMove{last.p2, last.i2, last.p1, last.i1}, -lastDelta);
+        applied = false;
+    }
+};
+
+// Перестановка случайной работы на другую позицию того же процессора.
+class ReorderMutation final : public MutationOperator {
+    Rng gen;
+    ShiftMove last;
+    long long lastDelta = 0;
+    bool applied = false;
+public:
+    explicit ReorderMutation(const Rng& gen = Rng()) : gen(gen) {}
+    const Rng& rng() const { return gen; }
+
+    void mutate(Solution& s) override { mutate(dynamic_cast<Schedule&>(s)); }
+    void undo(Solution& s) override { undo(dynamic_cast<Schedule&>(s)); }
+
+    void mutate(Schedule& sch) {
+        applied = pick_processor(gen, sch, 2, last.p1);
+        if (!applied) return;
+        int n = sch.jobCount(last.p1);
+        last.p2 = last.p1;
+        last.i1 = gen.below(n);
+        last.i2 = gen.below(n - 1);
+        if (last.i2 >= last.i1) last.i2++;
+        lastDelta = sch.deltaCost(last);
+        sch.applyMove(last, lastDelta);
+    }
+    void undo(Schedule& sch) {
+        if (!applied) return;
+        sch.applyMove(ShiftMove{last.p2, last.i2, last.p1, last.i1}, -lastDelta);
+        applied = false;
+    }
+};
+
+// Обмен двух соседних работ одного процессора; изменение K2 равно t_b - t_a.
+class AdjacentSwapMutation final : public MutationOperator {
+    Rng gen;
+    SwapMove last{};
+    long long lastDelta = 0;
+    bool applied = false;
+public:
+    explicit AdjacentSwapMutation(const Rng& gen = Rng()) : gen(gen) {}
+    const Rng& rng() const { return gen; }
+
+    void mutate(Solution& s) override { mutate(dynamic_cast<Schedule&>(s)); }
+    void undo(Solution& s) override { undo(dynamic_cast<Schedule&>(s)); }
+
+    void mutate(Schedule& sch) {
+        applied = pick_processor(gen, sch, 2, last.p1);
+        if (!applied) return;
+        last.p2 = last.p1;
+        last.i1 = gen.below(sch.jobCount(last.p1) - 1);
+        last.i2 = last.i1 + 1;
+        lastDelta = sch.deltaCost(last);
+        sch.applyMove(last, lastDelta);
+    }
+    void undo(Schedule& sch) {
+        if (!applied) return;
+        sch.applyMove(last, -lastDelta);
+        applied = false;
+    }
+};
+
+// Мультипопытка: tries случайных обменов за шаг, из которых выбирается один.
+// Кандидаты раскладываются по массивам (структура массивов), и каждый этап — позиции, номера работ,
+// длительности — проходит по всем кандидатам сразу. Загрузки из случайных мест расписания
+// независимы и выполняются параллельно, а не по одной за итерацию ИО; приращения K2 считаются
+// одним векторизуемым циклом. Кандидат выбирается с вероятностью exp(-(dF - dFmin) / T)
+// (при T -> 0 — лучший из tries), затем цикл ИО проверяет его по правилу Метрополиса как обычно.
+class MultiSwapMutation final : public MutationOperator {
+public:
+    static constexpr int MAX_TRIES = 64;
+    static constexpr int DEFAULT_TRIES = 8;
+
+private:
+    Rng gen;
+    int tries;
+    double temp = 0;
+    alignas(64) int p1[MAX_TRIES], i1[MAX_TRIES], p2[MAX_TRIES], i2[MAX_TRIES];
+    alignas(64) int job1[MAX_TRIES], job2[MAX_TRIES];
+    alignas(64) long long t1[MAX_TRIES], t2[MAX_TRIES], w1[MAX_TRIES], w2[MAX_TRIES], delta[MAX_TRIES];
+    SwapMove last{};
+    long long lastDelta = 0;
+    bool applied = false;
+
+    // Номер кандидата из n: exp(-(delta - dmin) / temp) как вес; веса ниже e^-40 не учитываются.
+    int choose(int n, long long dmin) {
+        if (!(temp > 0)) {
+            int c = 0;
+            while (delta[c] != dmin) c++;
+            return c;
+        }
+        double weight[MAX_TRIES], total = 0;
+        for (int k = 0; k < n; k++) {
+            double x = (delta[k] - dmin) / temp;
+            weight[k] = x < 40 ? std::exp(-x) : 0;
+            total += weight[k];
+        }
+        double u = gen.uniform() * total;
+        for (int k = 0; k < n - 1; k++) {
+            u -= weight[k];
+            if (u < 0) return k;
+        }
+        return n - 1;
+    }
+
+public:
+    explicit MultiSwapMutation(const Rng& gen = Rng(), int tries = DEFAULT_TRIES)
+        : gen(gen), tries(std::clamp(tries, 1, MAX_TRIES)) {}
+    const Rng& rng() const { return gen; }
+    int tryCount() const { return tries; }
+
+    void setTemperature(double t) override { temp = t; }
+    void mutate(Solution& s) override { mutate(dynamic_cast<Schedule&>(s)); }
+    void undo(Solution& s) override { undo(dynamic_cast<Schedule&>(s)); }
+
+    void mutate(Schedule& sch) {
+        const int* jobs = sch.jobs.data();
+        const int* offsets = sch.offsets.data();
+        int n = 0;
+        SwapMove mv;
+        for (int k = 0; k < tries; k++) {
+            if (!sch.proposeMove(gen, mv)) continue;
+            p1[n] = mv.p1;
+            i1[n] = mv.i1;
+            p2[n] = mv.p2;
+            i2[n] = mv.i2;
+            __builtin_prefetch(jobs + offsets[mv.p1] + mv.i1);
+            __builtin_prefetch(jobs + offsets[mv.p2] + mv.i2);
+            n++;
+        }
+        applied = n > 0;
+        if (!applied) return;
+        for (int k = 0; k < n; k++) {
+            job1[k] = jobs[offsets[p1[k]] + i1[k]];
+            job2[k] = jobs[offsets[p2[k]] + i2[k]];
+            w1[k] = sch.counts[p1[k]] - i1[k];
+            w2[k] = sch.counts[p2[k]] - i2[k];
+        }
+        for (int k = 0; k < n; k++) {
+            t1[k] = sch.jobTimes[job1[k]];
+            t2[k] = sch.jobTimes[job2[k]];
+        }
+        // То же, что Schedule::deltaCost(SwapMove), для всех кандидатов сразу.
+        if (sch.table.criterion == Criterion::K2) {
+            for (int k = 0; k < n; k++)
+                delta[k] = (t2[k] - t1[k]) * (w1[k] - w2[k]);
+        } else {
+            for (int k = 0; k < n; k++)
+                delta[k] = sch.deltaCost(SwapMove{p1[k], i1[k], p2[k], i2[k]});
+        }
+        long long dmin = delta[0];
+        for (int k = 1; k < n; k++)
+            dmin = std::min(dmin, delta[k]);
+        int c = choose(n, dmin);
+        last = SwapMove{p1[c], i1[c], p2[c], i2[c]};
+        lastDelta = delta[c];
+        sch.applyMove(last, lastDelta);
+    }
+    void undo(Schedule& sch) {
+        if (!applied) return;
+        sch.applyMove(last, -lastDelta);
+        applied = false;
+    }
+};
+
+// Статистика оператора в портфеле.
+struct OperatorStats {
+    const char* name;
+    long long proposed = 0;
+    long long accepted = 0;
+    long long improved = 0;
+    double score = 1.0;  // скользящее среднее награды
+};
+
+// Адаптивный портфель: на каждой итерации выбирает оператор с вероятностью, пропорциональной
+// скользящему среднему его награды (probability matching), но не меньше MIN_SHARE.
+// Награда хода: 1 за улучшение, ACCEPT_REWARD за принятый ход без улучшения, 0 за отказ.
+// Операторы хранятся по значению и вызываются через switch, без виртуальных вызовов.
+class PortfolioMutation final : public MutationOperator {
+public:
+    enum Kind { Swap, Move, Reorder, Adjacent, MultiSwap, KIND_COUNT };
+    static constexpr const char* NAMES[KIND_COUNT] = {"swap", "move", "reorder", "adjacent", "multiswap"};
+
+private:
+    static constexpr double DECAY = 0.01;
+    static constexpr double MIN_SHARE = 0.05;
+    static constexpr double ACCEPT_REWARD = 0.2;
+
+    Rng gen;
+    SwapMutation swap;
+    MoveMutation move;
+    ReorderMutation reorder;
+    AdjacentSwapMutation adjacent;
+    MultiSwapMutation multiSwap;
+    std::array<OperatorStats, KIND_COUNT> operatorStats;
+    std::array<int, KIND_COUNT> arms;  // включённые операторы
+    int armCount = 0;
+    int last = Swap;
+
+    int choose() {
+        if (armCount == 1) return arms[0];
+        double total = 0;
+        for (int a = 0; a < armCount; a++) total += operatorStats[arms[a]].score;
+        double floor = MIN_SHARE * total + 1e-12, spread = total + floor * armCount;
+        double u = gen.uniform() * spread;
+        for (int a = 0; a < armCount - 1; a++) {
+            u -= operatorStats[arms[a]].score + floor;
+            if (u < 0) return arms[a];
+        }
+        return arms[armCount - 1];
+    }
+
+public:
+    // mask — набор включённых операторов, бит (1 << Kind); tries — кандидатов у MultiSwap.
+    explicit PortfolioMutation(const Rng& seed = Rng(), unsigned mask = 1u << Swap,
+                               int tries = MultiSwapMutation::DEFAULT_TRIES)
+        : gen(seed) {
+        swap = SwapMutation(Rng(gen()));
+        move = MoveMutation(Rng(gen()));
+        reorder = ReorderMutation(Rng(gen()));
+        adjacent = AdjacentSwapMutation(Rng(gen()));
+        multiSwap = MultiSwapMutation(Rng(gen()), tries);
+        for (int k = 0; k < KIND_COUNT; k++) {
+            operatorStats[k].name = NAMES[k];
+            if (mask & (1u << k)) arms[armCount++] = k;
+        }
+        if (armCount == 0) arms[armCount++] = Swap;
+    }
+
+    // Разбирает список вида "swap,move" или "portfolio" (все операторы); 0 при ошибке.
+    static unsigned parseMask(const std::string& list) {
+        if (list == "portfolio") return (1u << KIND_COUNT) - 1;
+        unsigned mask = 0;
+        size_t from = 0;
+        while (from <= list.size()) {
+            size_t to = list.find(',', from);
+            if (to == std::string::npos) to = list.size();
+            std::string name = list.substr(from, to - from);
+            unsigned bit = 0;
+            for (int k = 0; k < KIND_COUNT; k++)
+                if (name == NAMES[k]) bit = 1u << k;
+            if (!bit) return 0;
+            mask |= bit;
+            from = to + 1;
+        }
+        return mask;
+    }
+
+    void mutate(Solution& s) override { mutate(dynamic_cast<Schedule&>(s)); }
+    void undo(Solution& s) override { undo(dynamic_cast<Schedule&>(s)); }
+
+    void mutate(Schedule& sch) {
+        last = choose();
+        operatorStats[last].proposed++;
+        switch (last) {
+        case Swap: swap.mutate(sch); break;
+        case Move: move.mutate(sch); break;
+        case Reorder: reorder.mutate(sch); break;
+        case Adjacent: adjacent.mutate(sch); break;
+        default: multiSwap.mutate(sch); break;
+        }
+    }
+    void undo(Schedule& sch) {
+        switch (last) {
+        case Swap: swap.undo(sch); break;
+        case Move: move.undo(sch); break;
+        case Reorder: reorder.undo(sch); break;
+        case Adjacent: adjacent.undo(sch); break;
+        default: multiSwap.undo(sch); break;
+        }
+    }
+
+    void setTemperature(double t) override { multiSwap.setTemperature(t); }
+
+    void feedback(bool accepted, double dF) override {
+        OperatorStats& st = operatorStats[last];
+        double reward = 0;
+        if (accepted) {
+            st.accepted++;
+            reward = ACCEPT_REWARD;
+        }
+        if (accepted && dF < 0) {
+            st.improved++;
+            reward = 1;
+        }
+        st.score += DECAY * (reward - st.score);
+    }
+
+    // Состояние между запусками ИО для контрольной точки: генераторы портфеля и операторов
+    // и статистика выбора. Журналы последних ходов не нужны — точка снимается между ходами.
+    struct State {
+        Rng gens[KIND_COUNT + 1];
+        double score[KIND_COUNT];
+        long long proposed[KIND_COUNT], accepted[KIND_COUNT], improved[KIND_COUNT];
+    };
+
+    State saveState() const {
+        State st = {{gen, swap.rng(), move.rng(), reorder.rng(), adjacent.rng(), multiSwap.rng()}, {}, {}, {}, {}};
+        for (int k = 0; k < KIND_COUNT; k++) {
+            st.score[k] = operatorStats[k].score;
+            st.proposed[k] = operatorStats[k].proposed;
+            st.accepted[k] = operatorStats[k].accepted;
+            st.improved[k] = operatorStats[k].improved;
+        }
+        return st;
+    }
+
+    void restoreState(const State& st) {
+        gen = st.gens[0];
+        swap = SwapMutation(st.gens[1 + Swap]);
+        move = MoveMutation(st.gens[1 + Move]);
+        reorder = ReorderMutation(st.gens[1 + Reorder]);
+        adjacent = AdjacentSwapMutation(st.gens[1 + Adjacent]);
+        multiSwap = MultiSwapMutation(st.gens[1 + MultiSwap], multiSwap.tryCount());
+        for (int k = 0; k < KIND_COUNT; k++) {
+            operatorStats[k].score = st.score[k];
+            operatorStats[k].proposed = st.proposed[k];
+            operatorStats[k].accepted = st.accepted[k];
+            operatorStats[k].improved = st.improved[k];
+        }
+    }
+
+    // Статистика включённых операторов.
+    std::vector<OperatorStats> stats() const {
+        std::vector<OperatorStats> out;
+        for (int a = 0; a < armCount; a++) out.push_back(operatorStats[arms[a]]);
+        return out;
+    }
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+#include <limits>
+
+// Генератор xoshiro256** (Blackman, Vigna): 32 байта состояния, несколько операций на число.
+// Удовлетворяет требованиям UniformRandomBitGenerator, поэтому годится и для std::shuffle.
+// Потоки рабочих получаются прыжком jump() на 2^128 шагов, так что не пересекаются.
+class Rng {
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    // splitmix64 разворачивает одно 64-битное зерно в полное состояние.
+    static uint64_t splitmix64(uint64_t& x) {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+public:
+    using result_type = uint64_t;
+    static constexpr uint64_t DEFAULT_SEED = 12345;
+
+    Rng() : Rng(DEFAULT_SEED) {}
+    explicit Rng(uint64_t seed) {
+        for (uint64_t& w : s) w = splitmix64(seed);
+    }
+
+    // Поток номер stream от зерна seed: stream прыжков от начального состояния.
+    static Rng stream(uint64_t seed, int stream) {
+        Rng r(seed);
+        for (int i = 0; i < stream; i++) r.jump();
+        return r;
+    }
+
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return std::numeric_limits<uint64_t>::max(); }
+
+    uint64_t operator()() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Число из [0, n) умножением вместо деления (Lemire); смещение не больше n / 2^32.
+    uint32_t below(uint32_t n) {
+        return uint32_t(((*this)() >> 32) * n >> 32);
+    }
+
+    // Число из [0, 1).
+    double uniform() {
+        return ((*this)() >> 11) * 0x1.0p-53;
+    }
+
+    // Эквивалент 2^128 вызовов operator().
+    void jump() {
+        static const uint64_t JUMP[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                        0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+        uint64_t t[4] = {0, 0, 0, 0};
+        for (uint64_t j : JUMP)
+            for (int b = 0; b < 64; b++) {
+                if (j & (uint64_t(1) << b))
+                    for (int i = 0; i < 4; i++) t[i] ^= s[i];
+                (*this)();
+            }
+        for (int i = 0; i < 4; i++) s[i] = t[i];
+    }
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include "telemetry.h"
+
+// Переводит двоичный журнал (sa_log_<рабочий>.bin или sa_log.bin) в прежний формат sa_log.csv.
+// Без фильтров выводит все записи файла; worker и run выбирают рабочего и номер запуска ИО.
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cout << "Usage: ./sa_log2csv <log.bin> <out.csv> [worker] [run]\n";
+        return 1;
+    }
+    int worker = argc > 3 ? std::atoi(argv[3]) : -1;
+    int run = argc > 4 ? std::atoi(argv[4]) : -1;
+
+    FILE* in = std::fopen(argv[1], "rb");
+    if (!in) {
+        std::cerr << "Ошибка открытия файла " << argv[1] << std::endl;
+        return 1;
+    }
+    std::ofstream out(argv[2]);
+    out << "Iteration,Temperature,CurrentCost,BestCost\n";
+    TelemetryRecord r;
+    while (std::fread(&r, sizeof(r), 1, in) == 1) {
+        if (worker >= 0 && r.worker != worker) continue;
+        if (run >= 0 && r.run != run) continue;
+        out << r.iter << "," << r.temp << "," << r.current << "," << r.best << "\n";
+    }
+    std::fclose(in);
+    return 0;
+}
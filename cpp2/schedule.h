@@ -0,0 +1,494 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <iostream>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include <memory>
+#include <span>
+#include "annealing.h"
+#include "rng.h"
+
+struct Job { int id; int duration; };
+
+// Минимизируемый критерий.
+enum class Criterion : int32_t {
+    K2 = 0,  // сумма времён завершения работ
+    K1 = 1   // разбалансированность: Tmax - Tmin по временам завершения работ
+};
+
+// Таблица длительностей работ: после загрузки не меняется и разделяется всеми копиями расписания.
+// owner удерживает память, в которой лежат длительности (вектор или разделяемый сегмент).
+// Критерий — часть постановки задачи, поэтому хранится здесь же и доходит до всех копий.
+struct JobTable {
+    const int* times = nullptr;
+    int size = 0;
+    std::shared_ptr<const void> owner;
+    Criterion criterion = Criterion::K2;
+
+    static JobTable fromVector(std::vector<int> v) {
+        auto data = std::make_shared<const std::vector<int>>(std::move(v));
+        return JobTable{data->data(), (int)data->size(), data};
+    }
+};
+
+// Времена завершения работ для K1 = Tmax - Tmin: дерево отрезков снизу вверх, лист n + p — процессор p.
+// На процессоре раньше всех завершается первая работа (в момент, равный её длительности),
+// позже всех — последняя (в момент, равный загрузке). Поэтому lo хранит минимум длительностей
+// первых работ, hi — максимум загрузок. Пустой процессор в K1 не участвует: его лист
+// нейтрален (NONE_LO, NONE_HI). Изменение листа и запрос по отрезку — O(log M), без просмотра всех M.
+class CompletionTree {
+    int n = 0;
+    std::vector<long long> lo, hi;
+public:
+    static constexpr long long NONE_LO = LLONG_MAX, NONE_HI = LLONG_MIN;
+
+    void build(const std::vector<long long>& first, const std::vector<long long>& last) {
+        n = first.size();
+        lo.assign(2 * n, NONE_LO);
+        hi.assign(2 * n, NONE_HI);
+        for (int p = 0; p < n; p++) {
+            lo[n + p] = first[p];
+            hi[n + p] = last[p];
+        }
+        for (int v = n - 1; v >= 1; v--) {
+            lo[v] = std::min(lo[2 * v], lo[2 * v + 1]);
+            hi[v] = std::max(hi[2 * v], hi[2 * v + 1]);
+        }
+    }
+
+    void update(int p, long long first, long long last) {
+        int v = n + p;
+        lo[v] = first;
+        hi[v] = last;
+        for (v >>= 1; v >= 1; v >>= 1) {
+            lo[v] = std::min(lo[2 * v], lo[2 * v + 1]);
+            hi[v] = std::max(hi[2 * v], hi[2 * v + 1]);
+        }
+    }
+
+    // Расширяет [mn, mx] экстремумами процессоров [l, r).
+    void query(int l, int r, long long& mn, long long& mx) const {
+        for (l += n, r += n; l < r; l >>= 1, r >>= 1) {
+            if (l & 1) {
+                mn = std::min(mn, lo[l]);
+                mx = std::max(mx, hi[l++]);
+            }
+            if (r & 1) {
+                mn = std::min(mn, lo[--r]);
+                mx = std::max(mx, hi[r]);
+            }
+        }
+    }
+};
+
+// Обмен работы i1 процессора p1 с работой i2 процессора p2 (p1 и p2 могут совпадать).
+struct SwapMove { int p1, i1, p2, i2; };
+
+// Перенос работы из позиции i1 процессора p1 в позицию i2 процессора p2; i2 — номер позиции
+// уже после переноса. При p1 == p2 это перестановка работы внутри процессора.
+// Обратный ход — перенос {p2, i2, p1, i1}.
+struct ShiftMove { int p1, i1, p2, i2; };
+
+class Schedule final : public Solution {
+public:
+    int N, M;
+    // Плоское представление: процессору p отведена область jobs[offsets[p] .. offsets[p + 1]),
+    // его работы занимают первые counts[p] мест области, остальное — запас для переносов.
+    // Копия расписания — несколько непрерывных массивов вместо M отдельных блоков в куче.
+    std::vector<int> jobs;
+    std::vector<int> offsets;
+    std::vector<int> counts;
+    JobTable table;
+    const int* jobTimes;
+    // Кэш: суммарная длительность работ каждого процессора и текущее значение критерия.
+    // Для K1 ведётся ещё дерево времён завершения первых и последних работ, для K2 оно не нужно.
+    std::vector<long long> loads;
+    CompletionTree completions;
+    long long cost = 0;
+
+    Schedule(int M, const JobTable& times, const std::vector<std::vector<int>>& processors)
+        : N(times.size), M(M), table(times), jobTimes(times.times) {
+        std::vector<int> sizes, compact;
+        for(const auto& p : processors) {
+            sizes.push_back(p.size());
+            compact.insert(compact.end(), p.begin(), p.end());
+        }
+        assign(sizes.data(), compact.data());
+    }
+
+    // Из компактной записи: sizes[p] работ процессора p, затем номера работ всех процессоров подряд.
+    Schedule(int M, const JobTable& times, const int* sizes, const int* compact)
+        : N(times.size), M(M), table(times), jobTimes(times.times) {
+        assign(sizes, compact);
+    }
+
+    // Случайное начальное расписание: работы перемешиваются генератором gen и раздаются по кругу.
+    Schedule(int M, const JobTable& times, Rng& gen)
+        : N(times.size), M(M), table(times), jobTimes(times.times) {
+        std::vector<int> order(N);
+        for(int i=0; i<N; i++) order[i]=i;
+        std::shuffle(order.begin(), order.end(), gen);
+        std::vector<int> sizes, compact;
+        dealRoundRobin(M, order, sizes, compact);
+        assign(sizes.data(), compact.data());
+    }
+
+    Schedule(int M, const std::vector<int>& times, Rng& gen)
+        : Schedule(M, JobTable::fromVector(times), gen) {}
+
+    // Правило SPT: работы в порядке возрастания длительности раздаются по кругу.
+    // Самые длинные M работ оказываются последними на своих процессорах (вес 1 в K2),
+    // следующие M — предпоследними и т. д., поэтому для K2 это расписание оптимально. O(N log N).
+    static Schedule spt(int M, const JobTable& times) {
+        std::vector<int> sizes, compact;
+        dealRoundRobin(M, sortedByDuration(times), sizes, compact);
+        return Schedule(M, times, sizes.data(), compact.data());
+    }
+
+    // Правило LPT: работы в порядке убывания длительности, каждая — на наименее загруженный
+    // процессор; выравнивает загрузки и уменьшает Tmax (критерий K1). Внутри процессора работы затем
+    // упорядочиваются по SPT, что не меняет загрузок и уменьшает K2. O(N log N).
+    static Schedule lpt(int M, const JobTable& times) {
+        std::vector<int> order = sortedByDuration(times);
+        std::vector<std::vector<int>> processors(M);
+        std::vector<std::pair<long long, int>> heap;  // (загрузка, процессор), минимум на вершине
+        for(int p = 0; p < M; ++p) heap.push_back({0, p});
+        auto greater = std::greater<std::pair<long long, int>>();
+        for(int i = times.size - 1; i >= 0; --i) {
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            heap.back().first += times.times[order[i]];
+            processors[heap.back().second].push_back(order[i]);
+            std::push_heap(heap.begin(), heap.end(), greater);
+        }
+        for(auto& jobs : processors)
+            std::reverse(jobs.begin(), jobs.end());
+        return Schedule(M, times, processors);
+    }
+
+    // Номера работ по возрастанию длительности.
+    static std::vector<int> sortedByDuration(const JobTable& times) {
+        std::vector<int> order(times.size);
+        for(int i = 0; i < times.size; i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(),
+                         [&](int a, int b) { return times.times[a] < times.times[b]; });
+        return order;
+    }
+
+    // Работы процессора p в порядке выполнения.
+    std::span<int> processor(int p) {
+        return {jobs.data() + offsets[p], size_t(counts[p])};
+    }
+    std::span<const int> processor(int p) const {
+        return {jobs.data() + offsets[p], size_t(counts[p])};
+    }
+    int jobCount(int p) const { return counts[p]; }
+
+    // Компактная запись для обмена: sizes[p] и номера работ всех процессоров подряд, без запаса.
+    void exportTo(int* sizes, int* compact) const {
+        for(int p = 0; p < M; ++p) {
+            sizes[p] = counts[p];
+            std::copy_n(jobs.data() + offsets[p], counts[p], compact);
+            compact += counts[p];
+        }
+    }
+
+    // Заменяет расписание компактной записью и пересчитывает кэш.
+    void assign(const int* sizes, const int* compact) {
+        counts.assign(sizes, sizes + M);
+        offsets.resize(M + 1);
+        int total = 0;
+        for(int p = 0; p < M; ++p) {
+            offsets[p] = total;
+            total += capacityFor(counts[p]);
+        }
+        offsets[M] = total;
+        jobs.assign(total, -1);
+        for(int p = 0; p < M; ++p) {
+            std::copy_n(compact, counts[p], jobs.data() + offsets[p]);
+            compact += counts[p];
+        }
+        recomputeCost();
+    }
+
+    // Полный пересчёт кэша за O(N); вызывается только при построении расписания.
+    void recomputeCost() {
+        loads.assign(M, 0);
+        cost = 0;
+        for(int proc = 0; proc < M; ++proc) {
+            long long currTime = 0;
+            for(int jobIdx : processor(proc)) {
+                currTime += jobTimes[jobIdx];
+                cost += currTime;
+            }
+            loads[proc] = currTime;
+        }
+        if (table.criterion == Criterion::K1) {
+            std::vector<long long> first(M), last(M);
+            for(int proc = 0; proc < M; ++proc) {
+                first[proc] = firstTime(proc);
+                last[proc] = lastTime(proc);
+            }
+            completions.build(first, last);
+            cost = M > 0 ? k1With(0, first[0], last[0], 0, first[0], last[0]) : 0;
+        }
+    }
+
+    // Длительность работы в позиции i процессора p.
+    long long timeAt(int p, int i) const { return jobTimes[jobs[offsets[p] + i]]; }
+
+    // Времена завершения первой и последней работ процессора p; у пустого — нейтральные значения.
+    long long firstTime(int p) const { return counts[p] ? timeAt(p, 0) : CompletionTree::NONE_LO; }
+    long long lastTime(int p) const { return counts[p] ? loads[p] : CompletionTree::NONE_HI; }
+
+    // K1, если у процессоров p1 и p2 первые и последние работы завершаются в first и last,
+    // а у остальных — как сейчас: три запроса к дереву по отрезкам между p1 и p2. O(log M).
+    // При p1 == p2 обе пары значений одинаковы. Без единой работы K1 = 0.
+    long long k1With(int p1, long long first1, long long last1, int p2, long long first2, long long last2) const {
+        if (p1 > p2) {
+            std::swap(p1, p2);
+            std::swap(first1, first2);
+            std::swap(last1, last2);
+        }
+        long long mn = std::min(first1, first2), mx = std::max(last1, last2);
+        completions.query(0, p1, mn, mx);
+        completions.query(p1 + 1, p2, mn, mx);
+        completions.query(p2 + 1, M, mn, mx);
+        return mn <= mx ? mx - mn : 0;
+    }
+
+    void updateCompletions(int p) { completions.update(p, firstTime(p), lastTime(p)); }
+
+    double getCost() const override { return cost; }
+
+    // Работа в позиции i процессора с k работами входит в K2 с весом (k - i):
+    // её длительность добавляется ко времени завершения её самой и всех работ после неё.
+    // Поэтому обмен двух работ меняет K2 на (t_b - t_a) * (w1 - w2) и считается за O(1).
+    // Для K1 обмен меняет загрузки p1 и p2 (на +d и -d) и первую работу процессора,
+    // если затрагивает позицию 0; обмен внутри процессора загрузку не меняет.
+    long long deltaCost(const SwapMove& mv) const {
+        long long ta = timeAt(mv.p1, mv.i1), tb = timeAt(mv.p2, mv.i2);
+        long long d = tb - ta;
+        if (table.criterion == Criterion::K1) {
+            if (mv.p1 == mv.p2) {
+                long long first = mv.i1 == 0 ? tb : mv.i2 == 0 ? ta : firstTime(mv.p1);
+                return k1With(mv.p1, first, loads[mv.p1], mv.p1, first, loads[mv.p1]) - cost;
+            }
+            return k1With(mv.p1, mv.i1 == 0 ? tb : firstTime(mv.p1), loads[mv.p1] + d,
+                          mv.p2, mv.i2 == 0 ? ta : firstTime(mv.p2), loads[mv.p2] - d) - cost;
+        }
+        long long w1 = jobCount(mv.p1) - mv.i1;
+        long long w2 = jobCount(mv.p2) - mv.i2;
+        return d * (w1 - w2);
+    }
+
+    void applyMove(const SwapMove& mv, long long delta) {
+        int& a = jobs[offsets[mv.p1] + mv.i1];
+        int& b = jobs[offsets[mv.p2] + mv.i2];
+        long long d = jobTimes[b] - jobTimes[a];
+        loads[mv.p1] += d;
+        loads[mv.p2] -= d;
+        cost += delta;
+        std::swap(a, b);
+        if (table.criterion == Criterion::K1) {
+            updateCompletions(mv.p1);
+            updateCompletions(mv.p2);
+        }
+    }
+
+    // Сумма длительностей работ в позициях [from, to) процессора p.
+    long long rangeTime(int p, int from, int to) const {
+        long long sum = 0;
+        const int* base = jobs.data() + offsets[p];
+        for(int i = from; i < to; i++) sum += jobTimes[base[i]];
+        return sum;
+    }
+
+    // Сумма длительностей работ перед позицией i; считается с более короткой стороны через loads.
+    long long prefixTime(int p, int i) const {
+        if (i <= counts[p] / 2) return rangeTime(p, 0, i);
+        return loads[p] - rangeTime(p, i, counts[p]);
+    }
+
+    // В терминах весов: у снятой работы пропадает вклад t * (k1 - i1), а у работ перед ней вес
+    // уменьшается на 1; вставка симметрична. Внутри процессора меняются веса только работ между
+    // i1 и i2. O(min(i, k - i)) для переноса и O(|i2 - i1|) для перестановки.
+    // Для K1 — как у обмена: новые загрузки и первые работы p1 и p2; процессор, с которого
+    // снята единственная работа, из K1 выпадает.
+    long long deltaCost(const ShiftMove& mv) const {
+        long long t = timeAt(mv.p1, mv.i1);
+        if (table.criterion == Criterion::K1) {
+            // Первая работа p1 после снятия работы i1 (без учёта вставки).
+            long long rest = mv.i1 > 0 ? timeAt(mv.p1, 0)
+                           : counts[mv.p1] > 1 ? timeAt(mv.p1, 1) : CompletionTree::NONE_LO;
+            if (mv.p1 == mv.p2) {
+                long long first = mv.i2 == 0 ? t : rest;
+                return k1With(mv.p1, first, loads[mv.p1], mv.p1, first, loads[mv.p1]) - cost;
+            }
+            long long last1 = counts[mv.p1] > 1 ? loads[mv.p1] - t : CompletionTree::NONE_HI;
+            return k1With(mv.p1, rest, last1, mv.p2, mv.i2 == 0 ? t : firstTime(mv.p2), loads[mv.p2] + t) - cost;
+        }
+        if (mv.p1 == mv.p2) {
+            if (mv.i2 > mv.i1) return rangeTime(mv.p1, mv.i1 + 1, mv.i2 + 1) - t * (mv.i2 - mv.i1);
+            return t * (mv.i1 - mv.i2) - rangeTime(mv.p1, mv.i2, mv.i1);
+        }
+        long long removed = t * (counts[mv.p1] - mv.i1) + prefixTime(mv.p1, mv.i1);
+        long long added = t * (counts[mv.p2] + 1 - mv.i2) + prefixTime(mv.p2, mv.i2);
+        return added - removed;
+    }
+
+    void applyMove(const ShiftMove& mv, long long delta) {
+        int job = eraseJob(mv.p1, mv.i1);
+        insertJob(mv.p2, mv.i2, job);
+        loads[mv.p1] -= jobTimes[job];
+        loads[mv.p2] += jobTimes[job];
+        cost += delta;
+        if (table.criterion == Criterion::K1) {
+            updateCompletions(mv.p1);
+            if (mv.p2 != mv.p1) updateCompletions(mv.p2);
+        }
+    }
+
+    // Выбирает случайный обмен между двумя разными процессорами; false, если ход невозможен.
+    // Пустые процессоры (после переносов работ) перевыбираются, а не дают холостую итерацию.
+    bool proposeMove(Rng& gen, SwapMove& mv) const {
+        if (M < 2) return false;
+        for (int attempt = 0; attempt < 8; attempt++) {
+            mv.p1 = gen.below(M);
+            // Второй процессор выбирается среди остальных M - 1 без повторных попыток.
+            mv.p2 = gen.below(M - 1);
+            if (mv.p2 >= mv.p1) mv.p2++;
+            int n1 = jobCount(mv.p1), n2 = jobCount(mv.p2);
+            if (n1 == 0 || n2 == 0) continue;
+            mv.i1 = gen.below(n1);
+            mv.i2 = gen.below(n2);
+            return true;
+        }
+        return false;
+    }
+
+    void applyMutation(MutationOperator& mut) override {
+        mut.mutate(*this);
+    }
+    void undoMutation(MutationOperator& mut) override {
+        mut.undo(*this);
+    }
+    Schedule* clone() const override { return new Schedule(*this); }
+    void copyFrom(const Solution& other) override {
+        copyFrom(dynamic_cast<const Schedule&>(other));
+    }
+    void copyFrom(const Schedule& s) {
+        N = s.N;
+        M = s.M;
+        jobs = s.jobs;
+        offsets = s.offsets;
+        counts = s.counts;
+        table = s.table;
+        jobTimes = s.jobTimes;
+        loads = s.loads;
+        completions = s.completions;
+        cost = s.cost;
+    }
+    void print() const {
+        for(int p = 0; p < M; ++p) {
+            std::cout << "Process " << p << ": ";
+            int t = 0;
+            for(int job: processor(p)) {
+                t += jobTimes[job];
+                std::cout << "(job="<< job << " Time=" << t << ") ";
+            }
+            std::cout << "\n";
+        }
+    }
+
+    void swapJobsRandom(Rng& gen) {
+        SwapMove mv;
+        if (!proposeMove(gen, mv)) return;
+        applyMove(mv, deltaCost(mv));
+    }
+
+private:
+    // Размер области процессора с count работами: запас на переносы без перекладки массива.
+    static int capacityFor(int count) { return count + count / 8 + 4; }
+
+    static void dealRoundRobin(int M, const std::vector<int>& order, std::vector<int>& sizes,
+                               std::vector<int>& compact) {
+        sizes.assign(M, 0);
+        compact.clear();
+        compact.reserve(order.size());
+        for(int p = 0; p < M; ++p)
+            for(size_t i = p; i < order.size(); i += M) {
+                compact.push_back(order[i]);
+                sizes[p]++;
+            }
+    }
+
+    int eraseJob(int p, int i) {
+        int* base = jobs.data() + offsets[p];
+        int job = base[i];
+        std::memmove(base + i, base + i + 1, (counts[p] - i - 1) * sizeof(int));
+        counts[p]--;
+        return job;
+    }
+
+    void insertJob(int p, int i, int job) {
+        if (offsets[p] + counts[p] == offsets[p + 1]) relayout();
+        int* base = jobs.data() + offsets[p];
+        std::memmove(base + i + 1, base + i, (counts[p] - i) * sizeof(int));
+        base[i] = job;
+        counts[p]++;
+    }
+
+    // Область процессора заполнена: все процессоры раскладываются заново с новым запасом. O(N + M).
+    // Вызывается посреди хода, поэтому кэш стоимости сохраняется как есть, а не пересчитывается.
+    void relayout() {
+        std::vector<int> sizes(M), compact(N);
+        exportTo(sizes.data(), compact.data());
+        long long keepCost = cost;
+        std::vector<long long> keepLoads = std::move(loads);
+        CompletionTree keepTree = std::move(completions);
+        assign(sizes.data(), compact.data());
+        cost = keepCost;
+        loads = std::move(keepLoads);
+        completions = std::move(keepTree);
+    }
+};
+
+class SwapMutation final : public MutationOperator {
+    // Собственный поток случайных чисел; оператор живёт всё время работы рабочего.
+    Rng gen;
+    // Журнал отката: последний применённый обмен и его вклад в критерий.
+    SwapMove last;
+    long long lastDelta = 0;
+    bool applied = false;
+public:
+    explicit SwapMutation(const Rng& gen = Rng()) : gen(gen) {}
+    const Rng& rng() const { return gen; }
+
+    void mutate(Solution& s) override {
+        mutate(dynamic_cast<Schedule&>(s));
+    }
+    void undo(Solution& s) override {
+        undo(dynamic_cast<Schedule&>(s));
+    }
+
+    // Невиртуальные варианты для SimulatedAnnealingT<Schedule, SwapMutation, ...>.
+    void mutate(Schedule& sch) {
+        applied = sch.proposeMove(gen, last);
+        if (!applied) return;
+        lastDelta = sch.deltaCost(last);
+        sch.applyMove(last, lastDelta);
+    }
+    void undo(Schedule& sch) {
+        if (!applied) return;
+        // Обмен обратен сам себе, а его вклад в K2 меняет знак.
+        sch.applyMove(last, -lastDelta);
+        applied = false;
+    }
+};
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Счётчики и замеры времени по фазам. Счётчики итераций ведёт сам цикл ИО (это несколько
+// сложений на итерацию); часы опрашиваются только на границах фаз и только если статистика
+// включена (--stats или --stats-socket), так что без неё накладные расходы отсутствуют.
+
+// Накопленные показатели рабочего. Рабочий ведёт их у себя и публикует копию в StatsBoard,
+// таблица которого лежит в разделяемом отображении, созданном до fork(): мастер видит
+// рабочих-процессов так же, как рабочих-потоков.
+struct WorkerStats {
+    long long runs = 0;
+    long long iterations = 0;
+    long long accepted = 0;
+    long long improved = 0;
+    double finalTemp = 0;     // температура в момент останова последнего запуска ИО
+    double annealSec = 0;     // работа цикла ИО
+    double serializeSec = 0;  // передача решения мастеру (сокет, слот в памяти, копия)
+    double waitSec = 0;       // ожидание решения от мастера или остальных рабочих
+
+    template <class SA>
+    void addRun(const SA& sa) {
+        runs++;
+        iterations += sa.getIterations();
+        accepted += sa.getAccepted();
+        improved += sa.getImproved();
+        finalTemp = sa.getTemperature();
+    }
+};
+
+// Раунд синхронизации с точки зрения мастера.
+struct RoundStats {
+    double waitSec;    // ожидание решений рабочих (с приёмом по сокету)
+    double reduceSec;  // выбор победителя и рассылка
+    double best;
+};
+
+// Секундомер фаз: lap() возвращает время с прошлого вызова; выключенный всегда возвращает 0.
+class PhaseClock {
+    std::chrono::steady_clock::time_point last;
+    bool on;
+public:
+    explicit PhaseClock(bool on) : last(std::chrono::steady_clock::now()), on(on) {}
+    double lap() {
+        if (!on) return 0;
+        auto now = std::chrono::steady_clock::now();
+        double d = std::chrono::duration<double>(now - last).count();
+        last = now;
+        return d;
+    }
+};
+
+class StatsBoard {
+    WorkerStats* workers = nullptr;
+    int Nproc;
+    bool enabled;
+    std::vector<RoundStats> rounds;
+    mutable std::mutex roundsMutex;  // rounds читает и поток живой статистики
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Живая строка статистики: отдельный поток мастера отдаёт текущий JSON в одну строку
+    // каждому, кто подключится к сокету (например, socat - UNIX-CONNECT:<путь>).
+    std::string livePath;
+    std::thread liveThread;
+    std::atomic<bool> liveStop{false};
+
+public:
+    StatsBoard(int Nproc, bool enabled) : Nproc(Nproc), enabled(enabled) {
+        if (!enabled) return;
+        void* p = mmap(nullptr, Nproc * sizeof(WorkerStats), PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        workers = static_cast<WorkerStats*>(p);
+        for (int i = 0; i < Nproc; i++) new (&workers[i]) WorkerStats();
+    }
+
+    StatsBoard(const StatsBoard&) = delete;
+    StatsBoard& operator=(const StatsBoard&) = delete;
+
+    ~StatsBoard() {
+        stopLive();
+        if (workers) munmap(workers, Nproc * sizeof(WorkerStats));
+    }
+
+    bool isEnabled() const { return enabled; }
+
+    void addRound(double waitSec, double reduceSec, double best) {
+        if (!enabled) return;
+        std::lock_guard<std::mutex> lock(roundsMutex);
+        rounds.push_back({waitSec, reduceSec, best});
+    }
+
+    // Снимок показателей рабочего id; рабочий вызывает его после каждого раунда.
+    void publish(int id, const WorkerStats& st) {
+        if (enabled) workers[id] = st;
+    }
+
+    // compact — одной строкой, для живой статистики.
+    void writeJson(std::ostream& out, bool compact = false) const {
+        const char* nl = compact ? "" : "\n";
+        const char* ind1 = compact ? "" : "  ";
+        const char* ind2 = compact ? "" : "    ";
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        out << "{" << nl << ind1 << "\"wallSec\": " << wall << "," << nl;
+        out << ind1 << "\"workers\": [" << nl;
+        for (int i = 0; i < Nproc; i++) {
+            const WorkerStats& w = workers[i];
+            out << ind2 << "{\"worker\": " << i << ", \"runs\": " << w.runs << ", \"iterations\": " << w.iterations
+                << ", \"accepted\": " << w.accepted << ", \"improved\": " << w.improved
+                << ", \"finalTemp\": " << w.finalTemp << ", \"annealSec\": " << w.annealSec
+                << ", \"serializeSec\": " << w.serializeSec << ", \"waitSec\": " << w.waitSec << "}"
+                << (i + 1 < Nproc ? "," : "") << nl;
+        }
+        out << ind1 << "]," << nl << ind1 << "\"rounds\": [" << nl;
+        std::lock_guard<std::mutex> lock(roundsMutex);
+        for (size_t r = 0; r < rounds.size(); r++) {
+            out << ind2 << "{\"round\": " << r << ", \"waitSec\": " << rounds[r].waitSec
+                << ", \"reduceSec\": " << rounds[r].reduceSec << ", \"best\": " << rounds[r].best << "}"
+                << (r + 1 < rounds.size() ? "," : "") << nl;
+        }
+        out << ind1 << "]" << nl << "}\n";
+    }
+
+    // Запускает поток живой статистики на сокете path. Вызывать в мастере после fork().
+    void serveLive(const std::string& path) {
+        if (!enabled || path.empty()) return;
+        livePath = path;
+        int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(path.c_str());
+        bind(sock, (sockaddr*)&addr, sizeof(addr));
+        listen(sock, 4);
+        liveThread = std::thread([this, sock]() {
+            pollfd pfd = {sock, POLLIN, 0};
+            while (!liveStop.load()) {
+                if (poll(&pfd, 1, 100) <= 0) continue;
+                int client = accept(sock, nullptr, nullptr);
+                if (client < 0) continue;
+                std::ostringstream line;
+                writeJson(line, true);
+                std::string s = line.str();
+                ssize_t ignored = write(client, s.data(), s.size());
+                (void)ignored;
+                close(client);
+            }
+            close(sock);
+        });
+    }
+
+    void stopLive() {
+        if (!liveThread.joinable()) return;
+        liveStop = true;
+        liveThread.join();
+        unlink(livePath.c_str());
+    }
+};
+
+#endif
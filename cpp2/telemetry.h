@@ -0,0 +1,164 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Журнал итераций ИО. Цикл ИО кладёт записи в кольцевой буфер своего рабочего, фоновый поток
+// процесса сбрасывает буферы в двоичные файлы. Конвертер sa_log2csv восстанавливает из них
+// прежний формат sa_log.csv.
+
+enum class LogMode {
+    Off,     // журнал не ведётся
+    Worker,  // отдельный файл sa_log_<рабочий>.bin
+    Merged   // общий файл sa_log.bin для всех рабочих
+};
+
+struct TelemetryConfig {
+    LogMode mode = LogMode::Worker;
+    int every = 1;  // записывать каждую every-ю итерацию
+};
+
+struct TelemetryRecord {
+    int32_t worker;
+    int32_t run;    // номер запуска ИО у этого рабочего
+    int64_t iter;
+    double temp;
+    double current;
+    double best;
+};
+
+const char* const MERGED_LOG_PATH = "sa_log.bin";
+
+inline std::string worker_log_path(int worker) {
+    return "sa_log_" + std::to_string(worker) + ".bin";
+}
+
+class TelemetryWriter;
+
+// Кольцевой буфер одного рабочего: один производитель (цикл ИО), один потребитель (TelemetryWriter).
+class TelemetrySink {
+    friend class TelemetryWriter;
+    static const size_t CAPACITY = 1 << 14;
+
+    TelemetryWriter* writer;
+    int fd;
+    int32_t worker;
+    int32_t run = -1;
+    int every;
+    int countdown = 0;
+    std::vector<TelemetryRecord> ring;
+    std::atomic<uint64_t> head{0};  // пишет только производитель
+    std::atomic<uint64_t> tail{0};  // пишет только потребитель
+
+    TelemetrySink(TelemetryWriter* writer, int fd, int worker, int every)
+        : writer(writer), fd(fd), worker(worker), every(every), ring(CAPACITY) {}
+
+    void push(const TelemetryRecord& r);
+
+    // Сбрасывает накопленные записи в файл; вызывается только потоком TelemetryWriter.
+    void drain() {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_acquire);
+        while (t < h) {
+            size_t from = t % CAPACITY;
+            size_t n = std::min<uint64_t>(h - t, CAPACITY - from);
+            if (write(fd, &ring[from], n * sizeof(TelemetryRecord)) < 0) break;
+            t += n;
+        }
+        tail.store(t, std::memory_order_release);
+    }
+
+public:
+    void beginRun() {
+        run++;
+        countdown = 0;
+    }
+
+    void sample(long long iter, double temp, double current, double best) {
+        if (--countdown > 0) return;
+        countdown = every;
+        push(TelemetryRecord{worker, run, iter, temp, current, best});
+    }
+};
+
+// Фоновый поток записи; один на процесс, обслуживает буферы всех рабочих этого процесса.
+class TelemetryWriter {
+    TelemetryConfig config;
+    std::vector<std::unique_ptr<TelemetrySink>> sinks;
+    std::vector<int> fds;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread thread;
+
+    void loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            wake.wait_for(lock, std::chrono::milliseconds(20));
+            for (auto& s : sinks) s->drain();
+        }
+        for (auto& s : sinks) s->drain();
+    }
+
+public:
+    explicit TelemetryWriter(const TelemetryConfig& config) : config(config) {
+        if (config.mode != LogMode::Off)
+            thread = std::thread(&TelemetryWriter::loop, this);
+    }
+
+    ~TelemetryWriter() {
+        if (thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            thread.join();
+        }
+        for (int fd : fds) close(fd);
+    }
+
+    // Обнуляет общий файл; мастер вызывает это один раз до запуска рабочих.
+    static void prepare(const TelemetryConfig& config) {
+        if (config.mode == LogMode::Merged)
+            close(::open(MERGED_LOG_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    }
+
+    // Буфер для рабочего worker; nullptr, если журнал отключён.
+    TelemetrySink* open(int worker) {
+        if (config.mode == LogMode::Off) return nullptr;
+        int fd = config.mode == LogMode::Merged
+            ? ::open(MERGED_LOG_PATH, O_WRONLY | O_CREAT | O_APPEND, 0644)
+            : ::open(worker_log_path(worker).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        std::lock_guard<std::mutex> lock(mutex);
+        fds.push_back(fd);
+        sinks.emplace_back(new TelemetrySink(this, fd, worker, config.every));
+        return sinks.back().get();
+    }
+
+    void notify() { wake.notify_one(); }
+};
+
+inline void TelemetrySink::push(const TelemetryRecord& r) {
+    uint64_t h = head.load(std::memory_order_relaxed);
+    // Буфер полон: будим писателя и ждём, записи не теряются.
+    while (h - tail.load(std::memory_order_acquire) >= CAPACITY) {
+        writer->notify();
+        std::this_thread::yield();
+    }
+    ring[h % CAPACITY] = r;
+    head.store(h + 1, std::memory_order_release);
+    if ((h + 1) % (CAPACITY / 2) == 0) writer->notify();
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef TEMPERING_H
+#define TEMPERING_H
+
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "rng.h"
+
+// Обмен репликами (parallel tempering). Реплика k всё время живёт при постоянной температуре
+// T_k (SimulatedAnnealingT с FixedTemperature и sweep()), а между отрезками работы соседние
+// реплики обмениваются состояниями. Горячие реплики свободно ходят по ландшафту, холодные
+// доводят найденное; обмен переносит удачные состояния вниз по лестнице.
+
+class TemperatureLadder {
+public:
+    std::vector<double> temps;        // ступень 0 — самая горячая, далее по убыванию
+    std::vector<long long> attempts;  // по парам ступеней (k, k + 1)
+    std::vector<long long> swaps;
+
+    // Геометрическая прогрессия от tMax до tMin: отношение соседних температур постоянно,
+    // поэтому при близких разбросах стоимостей доля обменов примерно одинакова по всей лестнице.
+    TemperatureLadder(int rungs, double tMin, double tMax)
+        : temps(rungs), attempts(rungs > 1 ? rungs - 1 : 0), swaps(attempts.size()) {
+        for (int k = 0; k < rungs; k++)
+            temps[k] = rungs == 1 ? tMin : tMax * std::pow(tMin / tMax, double(k) / (rungs - 1));
+    }
+
+    int size() const { return temps.size(); }
+
+    // Одна волна обменов: пары (k, k + 1) с чётным k в чётных раундах и с нечётным — в нечётных,
+    // так что пары не пересекаются. Обмен принимается с вероятностью
+    // min(1, exp((1/T_k - 1/T_{k+1}) * (E_k - E_{k+1}))); состояния меняются местами через
+    // std::swap, для Schedule это обмен буферов без копирования работ.
+    template <class Sol>
+    void exchange(const std::vector<Sol*>& states, int round, Rng& gen) {
+        for (int k = round % 2; k + 1 < size(); k += 2) {
+            attempts[k]++;
+            double x = (1 / temps[k] - 1 / temps[k + 1]) * (states[k]->getCost() - states[k + 1]->getCost());
+            if (x >= 0 || gen.uniform() < std::exp(x)) {
+                std::swap(*states[k], *states[k + 1]);
+                swaps[k]++;
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <unistd.h>
+#include "schedule.h"
+
+// ----------- Обмен через сокет -----------
+
+inline bool write_all(int fd, const void* buf, size_t n) {
+    const char* p = static_cast<const char*>(buf);
+    while (n > 0) {
+        ssize_t k = write(fd, p, n);
+        if (k <= 0) return false;
+        p += k;
+        n -= k;
+    }
+    return true;
+}
+
+inline bool read_all(int fd, void* buf, size_t n) {
+    char* p = static_cast<char*>(buf);
+    while (n > 0) {
+        ssize_t k = read(fd, p, n);
+        if (k <= 0) return false;
+        p += k;
+        n -= k;
+    }
+    return true;
+}
+
+// Сообщение: M, N, критерий, длительности работ, затем компактная запись расписания
+// (число работ каждого процессора и N номеров работ подряд) одним блоком.
+inline void send_schedule(int sock, const Schedule &s) {
+    write_all(sock, &s.M, sizeof(s.M));
+    write_all(sock, &s.N, sizeof(s.N));
+    write_all(sock, &s.table.criterion, sizeof(s.table.criterion));
+    write_all(sock, s.jobTimes, s.N * sizeof(int));
+    std::vector<int> compact(s.M + s.N);
+    s.exportTo(compact.data(), compact.data() + s.M);
+    write_all(sock, compact.data(), compact.size() * sizeof(int));
+}
+
+// Сообщение с M = 0 вместо расписания означает команду завершения рабочего.
+inline void send_stop(int sock) {
+    int M = 0;
+    write_all(sock, &M, sizeof(M));
+}
+
+// Принимает расписание в s; false, если пришла команда завершения, соединение закрыто
+// посреди сообщения или сообщение не складывается в расписание. s при этом не меняется.
+inline bool try_recv_schedule(int sock, Schedule& s) {
+    int M = 0, N = 0;
+    if (!read_all(sock, &M, sizeof(M)) || M <= 0) return false;
+    Criterion criterion;
+    if (!read_all(sock, &N, sizeof(N)) || N < 0) return false;
+    if (!read_all(sock, &criterion, sizeof(criterion))) return false;
+    std::vector<int> jobTimes(N);
+    if (!read_all(sock, jobTimes.data(), N * sizeof(int))) return false;
+    std::vector<int> compact(M + N);
+    if (!read_all(sock, compact.data(), compact.size() * sizeof(int))) return false;
+    long long total = 0;
+    for (int p = 0; p < M; ++p) {
+        if (compact[p] < 0) return false;
+        total += compact[p];
+    }
+    if (total != N) return false;
+    for (int i = M; i < M + N; ++i)
+        if (compact[i] < 0 || compact[i] >= N) return false;
+    JobTable table = JobTable::fromVector(std::move(jobTimes));
+    table.criterion = criterion;
+    s = Schedule(M, table, compact.data(), compact.data() + M);
+    return true;
+}
+
+inline Schedule recv_schedule(int sock) {
+    Schedule s(0, JobTable{}, {});
+    try_recv_schedule(sock, s);
+    return s;
+}
+
+// ----------- Обмен через разделяемую память -----------
+
+inline void futex_wait(std::atomic<uint32_t>* addr, uint32_t val) {
+    syscall(SYS_futex, addr, FUTEX_WAIT, val, nullptr, nullptr, 0);
+}
+
+inline void futex_wake_all(std::atomic<uint32_t>* addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// Сегмент memfd, который мастер создаёт и отображает до fork(), так что рабочие процессы
+// наследуют то же отображение. Длительности работ лежат в нём один раз.
+// У каждого рабочего свой слот из двух буферов: в раунде r он пишет буфер r % 2, пока остальные
+// ещё могут читать победителя раунда r - 1 из другого буфера. Мастер выбирает победителя по
+// стоимостям в заголовках буферов и публикует только номер слота и буфера, ничего не копируя.
+// Дополнительный слот с номером Nproc принадлежит мастеру и хранит стартовое расписание.
+// Готовность сигнализируется фьютексами на счётчиках submitted и published.
+class ShmExchange {
+    struct Header {
+        std::atomic<uint32_t> submitted;  // сколько решений сдано рабочими за всё время
+        std::atomic<uint32_t> published;  // сколько раз мастер опубликовал победителя
+        int winnerSlot, winnerBuf;
+        int N, M, Nproc;
+        Criterion criterion;
+    };
+
+    void* base = nullptr;
+    size_t size = 0;
+    size_t bufSize = 0;
+    Header* hdr = nullptr;
+    int* times = nullptr;
+
+    static size_t align64(size_t n) { return (n + 63) & ~size_t(63); }
+
+    // Буфер: стоимость, затем компактная запись расписания (см. Schedule::exportTo).
+    char* buffer(int slot, int buf) const {
+        size_t off = align64(sizeof(Header)) + align64(hdr->N * sizeof(int));
+        return static_cast<char*>(base) + off + (size_t(slot) * 2 + buf) * bufSize;
+    }
+    long long& bufCost(int slot, int buf) const { return *reinterpret_cast<long long*>(buffer(slot, buf)); }
+    int* bufSizes(int slot, int buf) const { return reinterpret_cast<int*>(buffer(slot, buf) + sizeof(long long)); }
+    int* bufJobs(int slot, int buf) const { return bufSizes(slot, buf) + hdr->M; }
+
+public:
+    ShmExchange(const JobTable& jobTimes, int M, int Nproc) {
+        int N = jobTimes.size;
+        bufSize = align64(sizeof(long long) + (size_t(M) + N) * sizeof(int));
+        size = align64(sizeof(Header)) + align64(N * sizeof(int)) + bufSize * 2 * (Nproc + 1);
+        int fd = memfd_create("sa_exchange", 0);
+        if (fd < 0 || ftruncate(fd, size) != 0)
+            throw std::runtime_error("memfd_create failed");
+        base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED)
+            throw std::runtime_error("mmap failed");
+        hdr = new (base) Header();
+        hdr->N = N;
+        hdr->M = M;
+        hdr->Nproc = Nproc;
+        hdr->criterion = jobTimes.criterion;
+        times = reinterpret_cast<int*>(static_cast<char*>(base) + align64(sizeof(Header)));
+        std::memcpy(times, jobTimes.times, N * sizeof(int));
+    }
+
+    ShmExchange(const ShmExchange&) = delete;
+    ShmExchange& operator=(const ShmExchange&) = delete;
+    ~ShmExchange() { munmap(base, size); }
+
+    // Таблица работ прямо в сегменте; сегмент живёт до конца процесса.
+    JobTable jobTable() const { return JobTable{times, hdr->N, nullptr, hdr->criterion}; }
+
+    void store(int slot, int buf, const Schedule& s) {
+        bufCost(slot, buf) = s.cost;
+        s.exportTo(bufSizes(slot, buf), bufJobs(slot, buf));
+    }
+
+    // Копирует расписание из буфера в собственную память читателя.
+    void load(int slot, int buf, Schedule& s) const {
+        s.assign(bufSizes(slot, buf), bufJobs(slot, buf));
+    }
+
+    // ---- сторона рабочего ----
+
+    void submit(int worker, int round, const Schedule& best) {
+        store(worker, round % 2, best);
+        hdr->submitted.fetch_add(1, std::memory_order_release);
+        futex_wake_all(&hdr->submitted);
+    }
+
+    // Ждёт count-ю публикацию мастера и загружает победителя в s.
+    void awaitPublished(uint32_t count, Schedule& s) {
+        uint32_t cur;
+        while ((cur = hdr->published.load(std::memory_order_acquire)) < count)
+            futex_wait(&hdr->published, cur);
+        load(hdr->winnerSlot, hdr->winnerBuf, s);
+    }
+
+    // ---- сторона мастера ----
+
+    void awaitSubmitted(uint32_t count) {
+        uint32_t cur;
+        while ((cur = hdr->submitted.load(std::memory_order_acquire)) < count)
+            futex_wait(&hdr->submitted, cur);
+    }
+
+    int bestWorker(int round) const {
+        int best = 0;
+        for (int w = 1; w < hdr->Nproc; w++)
+            if (bufCost(w, round % 2) < bufCost(best, round % 2)) best = w;
+        return best;
+    }
+
+    long long cost(int slot, int buf) const { return bufCost(slot, buf); }
+
+    void publish(int slot, int buf) {
+        hdr->winnerSlot = slot;
+        hdr->winnerBuf = buf;
+        hdr->published.fetch_add(1, std::memory_order_release);
+        futex_wake_all(&hdr->published);
+    }
+};
+
+#endif
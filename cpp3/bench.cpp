@@ -0,0 +1,175 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "function.h"
+#include "parallel.h"
+
+// --mode deriv (по умолчанию): стоимость одного вызова на глубоких выражениях - operator(),
+// GetDeriv, Eval и лента Compile - для двух форм дерева:
+//   chain - цепочка f_k = (f_{k-1} * p_k) / q_k, глубока только левая ветвь; узлов 4 * depth + 1;
+//   bushy - f_k = (f_{k-1} * g_{k-1}) / h_{k-1}, все три операнда - независимые деревья
+//           глубины k - 1; узлов 2 * 3^depth - 1.
+// GetDeriv произведения и частного кроме производных детей заново вычисляет их значения,
+// поэтому на каждом уровне вложенности поддерево обходится лишний раз: время GetDeriv растёт
+// как nodes * depth, у Eval и operator() - как nodes. Столбец deriv_per_eval показывает рост
+// этого отношения с глубиной.
+// --mode batch: наносекунды на точку сетки из --points точек, цикл по operator()/GetDeriv
+// против Evaluate/EvaluateDeriv.
+// --mode grid: точек в секунду у ParallelEvaluator::EvaluateGrid на --points точек
+// для 1, 2, 4, ... потоков до числа ядер.
+// Usage: ./bench [--mode deriv|batch|grid] [--seconds S] [--depth 16,64,256,1024] [--bushy-depth 2,4,6,8]
+//                [--points N]
+
+// Не даёт компилятору выбросить вычисление, результат которого не используется.
+volatile double benchSink;
+
+// Повторяет body пачками, пока не пройдёт seconds; возвращает наносекунды на вызов.
+template <class F>
+double ns_per_call(double seconds, F body) {
+    long long calls = 0, batch = 1;
+    double elapsed = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while (elapsed < seconds) {
+        for (long long i = 0; i < batch; i++) body();
+        calls += batch;
+        if (batch < (1 << 20)) batch *= 2;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+    return elapsed * 1e9 / calls;
+}
+
+TFunctionPtr deep_expression(int depth) {
+    TFunctionPtr f = FunctionFactory::Create("ident");
+    for (int k = 0; k < depth; ++k) {
+        auto p = FunctionFactory::Create("polynomial", {1, 0.001 * k});
+        auto q = FunctionFactory::Create("polynomial", {1, 0, 0.001});
+        f = *(*f * *p) / *q;
+    }
+    return f;
+}
+
+// Все три операнда каждого уровня строятся заново, общих поддеревьев нет.
+TFunctionPtr bushy_expression(int depth, int& seed) {
+    if (depth == 0) return FunctionFactory::Create("polynomial", {1, 0.001 * seed++});
+    TFunctionPtr f = bushy_expression(depth - 1, seed);
+    TFunctionPtr g = bushy_expression(depth - 1, seed);
+    TFunctionPtr h = bushy_expression(depth - 1, seed);
+    return *(*f * *g) / *h;
+}
+
+// Число узлов bushy_expression(depth): n_k = 3 n_{k-1} + 2, n_0 = 1.
+long long bushy_nodes(int depth) {
+    return depth == 0 ? 1 : 3 * bushy_nodes(depth - 1) + 2;
+}
+
+std::vector<int> parse_list(const char* s) {
+    std::vector<int> out;
+    std::stringstream in(s);
+    std::string item;
+    while (std::getline(in, item, ',')) out.push_back(std::stoi(item));
+    return out;
+}
+
+void bench_deriv(double seconds, const char* shape, int depth, long long nodes, const TFunctionPtr& f) {
+    const double x = 0.5;
+    CompiledFunction tape = Compile(f);
+    double value = ns_per_call(seconds, [&] { benchSink = (*f)(x); });
+    double deriv = ns_per_call(seconds, [&] { benchSink = f->GetDeriv(x); });
+    double eval = ns_per_call(seconds, [&] { benchSink = f->Eval(x).deriv; });
+    double compiled = ns_per_call(seconds, [&] { benchSink = tape.GetDeriv(x); });
+    std::cout << shape << ',' << depth << ',' << nodes << ',' << value << ',' << deriv << ',' << eval << ','
+              << compiled << ',' << deriv / eval << std::endl;
+}
+
+void bench_batch(double seconds, size_t points) {
+    auto x = FunctionFactory::Create("ident");
+    auto p = FunctionFactory::Create("polynomial", {1, -2, 0.5, 3, -1, 0.25, 2, -0.125});
+    auto e = FunctionFactory::Create("exp");
+    auto w = FunctionFactory::Create("power", {5});
+    std::vector<std::pair<std::string, TFunctionPtr>> funcs = {
+        {"polynomial7", p},
+        {"exp", e},
+        {"power5", w},
+        {"composite", *(*(*p * *e) - *w) / *(*(*x * *x) + *FunctionFactory::Create("const", {1}))},
+    };
+    std::vector<double> xs(points), out(points);
+    for (size_t i = 0; i < points; ++i) xs[i] = -2.0 + 4.0 * i / points;
+
+    std::cout << "function,points,scalar_ns,batch_ns,scalar_deriv_ns,batch_deriv_ns" << std::endl;
+    for (const auto& [name, f] : funcs) {
+        double scalar = ns_per_call(seconds, [&] {
+            for (size_t i = 0; i < points; ++i) out[i] = (*f)(xs[i]);
+            benchSink = out[points / 2];
+        });
+        double batch = ns_per_call(seconds, [&] {
+            f->Evaluate(xs, out);
+            benchSink = out[points / 2];
+        });
+        double scalarDeriv = ns_per_call(seconds, [&] {
+            for (size_t i = 0; i < points; ++i) out[i] = f->GetDeriv(xs[i]);
+            benchSink = out[points / 2];
+        });
+        double batchDeriv = ns_per_call(seconds, [&] {
+            f->EvaluateDeriv(xs, out);
+            benchSink = out[points / 2];
+        });
+        std::cout << name << ',' << points << ',' << scalar / points << ',' << batch / points << ','
+                  << scalarDeriv / points << ',' << batchDeriv / points << std::endl;
+    }
+}
+
+void bench_grid(double seconds, size_t points) {
+    auto p = FunctionFactory::Create("polynomial", {1, -2, 0.5, 3, -1, 0.25, 2, -0.125});
+    auto f = *(*p * *FunctionFactory::Create("exp")) / *FunctionFactory::Create("polynomial", {2, 0, 1});
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "threads,points,points_per_sec,speedup" << std::endl;
+    double base = 0;
+    for (unsigned threads = 1;; threads = std::min(cores, threads * 2)) {
+        ParallelEvaluator evaluator(threads);
+        double ns = ns_per_call(seconds, [&] { benchSink = evaluator.EvaluateGrid(f, -2, 2, points)[points / 2]; });
+        double rate = points * 1e9 / ns;
+        if (threads == 1) base = rate;
+        std::cout << threads << ',' << points << ',' << rate << ',' << rate / base << std::endl;
+        if (threads == cores) break;
+    }
+}
+
+int main(int argc, char** argv) {
+    double seconds = 0.2;
+    std::vector<int> depths = {16, 64, 256, 1024};
+    std::vector<int> bushyDepths = {2, 4, 6, 8};
+    std::string mode = "deriv";
+    size_t points = 1000000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--seconds")) seconds = std::stod(argv[i + 1]);
+        else if (!strcmp(argv[i], "--depth")) depths = parse_list(argv[i + 1]);
+        else if (!strcmp(argv[i], "--bushy-depth")) bushyDepths = parse_list(argv[i + 1]);
+        else if (!strcmp(argv[i], "--mode")) mode = argv[i + 1];
+        else if (!strcmp(argv[i], "--points")) points = std::stoul(argv[i + 1]);
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--mode deriv|batch|grid] [--seconds S] [--depth 16,64,256,1024]"
+                      << " [--bushy-depth 2,4,6,8] [--points N]" << std::endl;
+            return 1;
+        }
+    }
+    if (mode == "batch") {
+        bench_batch(seconds, points);
+        return 0;
+    }
+    if (mode == "grid") {
+        bench_grid(seconds, points);
+        return 0;
+    }
+
+    std::cout << "shape,depth,nodes,value_ns,getderiv_ns,eval_ns,tape_deriv_ns,deriv_per_eval" << std::endl;
+    for (int depth : depths) bench_deriv(seconds, "chain", depth, 4LL * depth + 1, deep_expression(depth));
+    for (int depth : bushyDepths) {
+        int seed = 0;
+        bench_deriv(seconds, "bushy", depth, bushy_nodes(depth), bushy_expression(depth, seed));
+    }
+    return 0;
+}
@@ -8,10 +8,25 @@
 #include <cmath>
 #include <algorithm>
 #include <iostream>
+#include <span>
+#include "simd.h"
 
 class TFunction;
 using TFunctionPtr = std::shared_ptr<TFunction>;
 
+class Tape;
+class BatchScratch;
+
+// Значение функции и её производная в одной точке.
+struct Dual {
+    double value;
+    double deriv;
+};
+
+// Выражения неизменяемы после построения: узлы не меняют своих полей, а operator(), GetDeriv,
+// Eval, Evaluate и EvaluateDeriv не трогают общего изменяемого состояния (промежуточные блоки
+// Evaluate свои у каждого вызова). Поэтому одно дерево можно вычислять из нескольких потоков
+// одновременно без блокировок (см. parallel.h).
 class TFunction {
 public:
     virtual ~TFunction() = default;
@@ -19,10 +34,77 @@ public:
     virtual double operator()(double x) const = 0;
     
     virtual double GetDeriv(double x) const = 0;
+
+    // Значение и производная за один обход дерева (прямой режим автоматического дифференцирования).
+    virtual Dual Eval(double x) const = 0;
     
     virtual std::string ToString() const = 0;
     
     virtual TFunctionPtr Clone() const = 0;
+
+    // Дописывает узел в ленту в постфиксном порядке (см. Compile).
+    virtual void EmitTo(Tape& tape) const = 0;
+
+    // Пакетное вычисление: out[i] = f(xs[i]) и out[i] = f'(xs[i]). Точки идут блоками
+    // по kBatchBlock, внутри блока каждый узел обрабатывает весь блок за один вызов.
+    // Результаты совпадают со скалярными с точностью до округления (Горнер, векторная exp).
+    void Evaluate(std::span<const double> xs, std::span<double> out) const;
+    void EvaluateDeriv(std::span<const double> xs, std::span<double> out) const;
+
+    // Значения блока из n <= kBatchBlock точек в val; при der != nullptr ещё производные в der.
+    // Промежуточные блоки составные узлы берут из scratch.
+    virtual void EvalBlock(const double* xs, double* val, double* der, size_t n, BatchScratch& scratch) const = 0;
+
+    static constexpr size_t kBatchBlock = 256;
+};
+
+// Стек блоков по kBatchBlock чисел для промежуточных результатов пакетного вычисления.
+// Блоки выделяются один раз и переиспользуются от блока к блоку; указатели не сдвигаются.
+class BatchScratch {
+    std::vector<std::unique_ptr<double[]>> blocks_;
+    size_t top_ = 0;
+public:
+    double* Take() {
+        if (top_ == blocks_.size()) blocks_.push_back(std::make_unique<double[]>(TFunction::kBatchBlock));
+        return blocks_[top_++].get();
+    }
+    void Release(size_t count) { top_ -= count; }
+};
+
+// Линейная запись выражения: листья кладут значение на стек, бинарные операции
+// снимают два верхних значения и кладут результат.
+class Tape {
+public:
+    enum class Op : unsigned char { Ident, Const, Power, Exp, Poly, Add, Sub, Mul, Div };
+
+    struct Instr {
+        Op op;
+        int arg = 0;    // показатель степени или индекс в consts
+        int count = 0;  // число коэффициентов полинома
+    };
+
+    std::vector<Instr> code;
+    std::vector<double> consts;
+    int maxDepth = 0;
+
+    void Leaf(Op op, int arg = 0, int count = 0) {
+        code.push_back({op, arg, count});
+        maxDepth = std::max(maxDepth, ++depth_);
+    }
+
+    void Binary(Op op) {
+        code.push_back({op});
+        --depth_;
+    }
+
+    int AddConsts(const std::vector<double>& values) {
+        int offset = static_cast<int>(consts.size());
+        consts.insert(consts.end(), values.begin(), values.end());
+        return offset;
+    }
+
+private:
+    int depth_ = 0;
 };
 
 class UnsupportedOperation : public std::logic_error {
@@ -40,8 +122,14 @@ class IdentityFunction : public TFunction {
 public:
     double operator()(double x) const override { return x; }
     double GetDeriv(double) const override { return 1.0; }
+    Dual Eval(double x) const override { return {x, 1.0}; }
     std::string ToString() const override { return "IdentityFunc x"; }
     TFunctionPtr Clone() const override { return std::make_shared<IdentityFunction>(); }
+    void EmitTo(Tape& tape) const override { tape.Leaf(Tape::Op::Ident); }
+    void EvalBlock(const double* xs, double* val, double* der, size_t n, BatchScratch&) const override {
+        std::copy(xs, xs + n, val);
+        if (der) std::fill(der, der + n, 1.0);
+    }
 };
 
 class ConstFunction : public TFunction {
@@ -50,8 +138,14 @@ public:
     explicit ConstFunction(double value) : value_(value) {}
     double operator()(double) const override { return value_; }
     double GetDeriv(double) const override { return 0.0; }
+    Dual Eval(double) const override { return {value_, 0.0}; }
     std::string ToString() const override { return "Const " + std::to_string(value_); }
     TFunctionPtr Clone() const override { return std::make_shared<ConstFunction>(value_); }
+    void EmitTo(Tape& tape) const override { tape.Leaf(Tape::Op::Const, tape.AddConsts({value_})); }
+    void EvalBlock(const double*, double* val, double* der, size_t n, BatchScratch&) const override {
+        std::fill(val, val + n, value_);
+        if (der) std::fill(der, der + n, 0.0);
+    }
 };
 
 class PowerFunction : public TFunction {
@@ -63,18 +157,32 @@ public:
         if (power_ == 0) return 0.0;
         return power_ * std::pow(x, power_ - 1);
     }
+    Dual Eval(double x) const override { return {(*this)(x), GetDeriv(x)}; }
     std::string ToString() const override { 
         return "PowerFunc x^" + std::to_string(power_); 
     }
     TFunctionPtr Clone() const override { return std::make_shared<PowerFunction>(power_); }
+    void EmitTo(Tape& tape) const override { tape.Leaf(Tape::Op::Power, power_); }
+    void EvalBlock(const double* xs, double* val, double* der, size_t n, BatchScratch&) const override {
+        PowBlock(xs, power_, val, der, n);
+    }
 };
 
 class ExpFunction : public TFunction {
 public:
     double operator()(double x) const override { return std::exp(x); }
     double GetDeriv(double x) const override { return std::exp(x); }
+    Dual Eval(double x) const override {
+        double e = std::exp(x);
+        return {e, e};
+    }
     std::string ToString() const override { return "ExpFunc exp(x)"; }
     TFunctionPtr Clone() const override { return std::make_shared<ExpFunction>(); }
+    void EmitTo(Tape& tape) const override { tape.Leaf(Tape::Op::Exp); }
+    void EvalBlock(const double* xs, double* val, double* der, size_t n, BatchScratch&) const override {
+        ExpBlock(xs, val, n);
+        if (der) std::copy(val, val + n, der);
+    }
 };
 
 class PolynomialFunction : public TFunction {
@@ -101,6 +209,17 @@ public:
         }
         return result;
     }
+
+    Dual Eval(double x) const override {
+        Dual result{0, 0};
+        double x_power = 1;
+        for (size_t i = 0; i < coeffs_.size(); ++i) {
+            result.value += coeffs_[i] * x_power;
+            if (i + 1 < coeffs_.size()) result.deriv += coeffs_[i + 1] * (i + 1) * x_power;
+            x_power *= x;
+        }
+        return result;
+    }
     
     std::string ToString() const override {
         std::string result;
@@ -124,6 +243,14 @@ public:
     TFunctionPtr Clone() const override { 
         return std::make_shared<PolynomialFunction>(coeffs_); 
     }
+
+    void EmitTo(Tape& tape) const override {
+        tape.Leaf(Tape::Op::Poly, tape.AddConsts(coeffs_), static_cast<int>(coeffs_.size()));
+    }
+
+    void EvalBlock(const double* xs, double* val, double* der, size_t n, BatchScratch&) const override {
+        HornerBlock(coeffs_.data(), coeffs_.size(), xs, val, der, n);
+    }
 };
 
 class SumFunction : public TFunction {
@@ -138,6 +265,11 @@ public:
     double GetDeriv(double x) const override {
         return left_->GetDeriv(x) + right_->GetDeriv(x);
     }
+
+    Dual Eval(double x) const override {
+        Dual f = left_->Eval(x), g = right_->Eval(x);
+        return {f.value + g.value, f.deriv + g.deriv};
+    }
     
     std::string ToString() const override {
         return "(" + left_->ToString() + " + " + right_->ToString() + ")";
@@ -146,6 +278,24 @@ public:
     TFunctionPtr Clone() const override {
         return std::make_shared<SumFunction>(left_, right_);
     }
+
+    void EmitTo(Tape& tape) const override {
+        left_->EmitTo(tape);
+        right_->EmitTo(tape);
+        tape.Binary(Tape::Op::Add);
+    }
+
+    void EvalBlock(const double* xs, double* val, double* der, size_t n, BatchScratch& scratch) const override {
+        left_->EvalBlock(xs, val, der, n, scratch);
+        double* g = scratch.Take();
+        double* dg = der ? scratch.Take() : nullptr;
+        right_->EvalBlock(xs, g, dg, n, scratch);
+        for (size_t i = 0; i < n; ++i) val[i] += g[i];
+        if (der) {
+            for (size_t i = 0; i < n; ++i) der[i] += dg[i];
+        }
+        scratch.Release(der ? 2 : 1);
+    }
 };
 
 class DifferenceFunction : public TFunction {
@@ -160,6 +310,11 @@ public:
     double GetDeriv(double x) const override {
         return left_->GetDeriv(x) - right_->GetDeriv(x);
     }
+
+    Dual Eval(double x) const override {
+        Dual f = left_->Eval(x), g = right_->Eval(x);
+        return {f.value - g.value, f.deriv - g.deriv};
+    }
     
     std::string ToString() const override {
         return "(" + left_->ToString() + " - " + right_->ToString() + ")";
@@ -168,6 +323,24 @@ public:
     TFunctionPtr Clone() const override {
         return std::make_shared<DifferenceFunction>(left_, right_);
     }
+
+    void EmitTo(Tape& tape) const override {
+        left_->EmitTo(tape);
+        right_->EmitTo(tape);
+        tape.Binary(Tape::Op::Sub);
+    }
+
+    void EvalBlock(const double* xs, double* val, double* der, size_t n, BatchScratch& scratch) const override {
+        left_->EvalBlock(xs, val, der, n, scratch);
+        double* g = scratch.Take();
+        double* dg = der ? scratch.Take() : nullptr;
+        right_->EvalBlock(xs, g, dg, n, scratch);
+        for (size_t i = 0; i < n; ++i) val[i] -= g[i];
+        if (der) {
+            for (size_t i = 0; i < n; ++i) der[i] -= dg[i];
+        }
+        scratch.Release(der ? 2 : 1);
+    }
 };
 
 class ProductFunction : public TFunction {
@@ -182,6 +355,11 @@ public:
     double GetDeriv(double x) const override {
         return left_->GetDeriv(x) * (*right_)(x) + (*left_)(x) * right_->GetDeriv(x);
     }
+
+    Dual Eval(double x) const override {
+        Dual f = left_->Eval(x), g = right_->Eval(x);
+        return {f.value * g.value, f.deriv * g.value + f.value * g.deriv};
+    }
     
     std::string ToString() const override {
         return "ProductFunc (" + left_->ToString() + " * " + right_->ToString() + ")";
@@ -190,6 +368,24 @@ public:
     TFunctionPtr Clone() const override {
         return std::make_shared<ProductFunction>(left_, right_);
     }
+
+    void EmitTo(Tape& tape) const override {
+        left_->EmitTo(tape);
+        right_->EmitTo(tape);
+        tape.Binary(Tape::Op::Mul);
+    }
+
+    void EvalBlock(const double* xs, double* val, double* der, size_t n, BatchScratch& scratch) const override {
+        left_->EvalBlock(xs, val, der, n, scratch);
+        double* g = scratch.Take();
+        double* dg = der ? scratch.Take() : nullptr;
+        right_->EvalBlock(xs, g, dg, n, scratch);
+        if (der) {
+            for (size_t i = 0; i < n; ++i) der[i] = der[i] * g[i] + val[i] * dg[i];
+        }
+        for (size_t i = 0; i < n; ++i) val[i] *= g[i];
+        scratch.Release(der ? 2 : 1);
+    }
 };
 
 class QuotientFunction : public TFunction {
@@ -217,6 +413,14 @@ public:
         
         return (f_prime * g - f * g_prime) / (g * g);
     }
+
+    Dual Eval(double x) const override {
+        Dual f = left_->Eval(x), g = right_->Eval(x);
+        if (std::abs(g.value) < 1e-12) {
+            throw std::logic_error("Division by zero");
+        }
+        return {f.value / g.value, (f.deriv * g.value - f.value * g.deriv) / (g.value * g.value)};
+    }
     
     std::string ToString() const override {
         return "(" + left_->ToString() + " / " + right_->ToString() + ")";
@@ -225,9 +429,49 @@ public:
     TFunctionPtr Clone() const override {
         return std::make_shared<QuotientFunction>(left_, right_);
     }
+
+    void EmitTo(Tape& tape) const override {
+        left_->EmitTo(tape);
+        right_->EmitTo(tape);
+        tape.Binary(Tape::Op::Div);
+    }
+
+    void EvalBlock(const double* xs, double* val, double* der, size_t n, BatchScratch& scratch) const override {
+        left_->EvalBlock(xs, val, der, n, scratch);
+        double* g = scratch.Take();
+        double* dg = der ? scratch.Take() : nullptr;
+        right_->EvalBlock(xs, g, dg, n, scratch);
+        for (size_t i = 0; i < n; ++i) {
+            if (std::abs(g[i]) < 1e-12) throw std::logic_error("Division by zero");
+        }
+        if (der) {
+            for (size_t i = 0; i < n; ++i) der[i] = (der[i] * g[i] - val[i] * dg[i]) / (g[i] * g[i]);
+        }
+        for (size_t i = 0; i < n; ++i) val[i] /= g[i];
+        scratch.Release(der ? 2 : 1);
+    }
 };
 
-TFunctionPtr FunctionFactory::Create(const std::string& type, const std::vector<double>& params) {
+inline void TFunction::Evaluate(std::span<const double> xs, std::span<double> out) const {
+    if (xs.size() != out.size()) throw std::invalid_argument("Evaluate: xs and out sizes differ");
+    BatchScratch scratch;
+    for (size_t i = 0; i < xs.size(); i += kBatchBlock) {
+        size_t n = std::min(kBatchBlock, xs.size() - i);
+        EvalBlock(xs.data() + i, out.data() + i, nullptr, n, scratch);
+    }
+}
+
+inline void TFunction::EvaluateDeriv(std::span<const double> xs, std::span<double> out) const {
+    if (xs.size() != out.size()) throw std::invalid_argument("EvaluateDeriv: xs and out sizes differ");
+    BatchScratch scratch;
+    double* val = scratch.Take();
+    for (size_t i = 0; i < xs.size(); i += kBatchBlock) {
+        size_t n = std::min(kBatchBlock, xs.size() - i);
+        EvalBlock(xs.data() + i, val, out.data() + i, n, scratch);
+    }
+}
+
+inline TFunctionPtr FunctionFactory::Create(const std::string& type, const std::vector<double>& params) {
     if (type == "ident") {
         return std::make_shared<IdentityFunction>();
     } else if (type == "const") {
@@ -245,7 +489,7 @@ TFunctionPtr FunctionFactory::Create(const std::string& type, const std::vector<
     throw std::invalid_argument("Unknown function type: " + type);
 }
 
-TFunctionPtr operator+(const TFunction& lhs, const TFunction& rhs) {
+inline TFunctionPtr operator+(const TFunction& lhs, const TFunction& rhs) {
     return std::make_shared<SumFunction>(lhs.Clone(), rhs.Clone());
 }
 
@@ -259,7 +503,7 @@ TFunctionPtr operator+(const T&, const TFunction& rhs) {
         throw std::logic_error("Unsupported type for operator+");
 }
 
-TFunctionPtr operator-(const TFunction& lhs, const TFunction& rhs) {
+inline TFunctionPtr operator-(const TFunction& lhs, const TFunction& rhs) {
     return std::make_shared<DifferenceFunction>(lhs.Clone(), rhs.Clone());
 }
 
@@ -273,7 +517,7 @@ TFunctionPtr operator-(const T&, const TFunction&) {
         throw std::logic_error("Unsupported type for operator-");
 }
 
-TFunctionPtr operator*(const TFunction& lhs, const TFunction& rhs) {
+inline TFunctionPtr operator*(const TFunction& lhs, const TFunction& rhs) {
     return std::make_shared<ProductFunction>(lhs.Clone(), rhs.Clone());
 }
 
@@ -287,7 +531,7 @@ TFunctionPtr operator*(const T&, const TFunction&) {
         throw std::logic_error("Unsupported type for operator*");
 }
 
-TFunctionPtr operator/(const TFunction& lhs, const TFunction& rhs) {
+inline TFunctionPtr operator/(const TFunction& lhs, const TFunction& rhs) {
     return std::make_shared<QuotientFunction>(lhs.Clone(), rhs.Clone());
 }
 
@@ -301,15 +545,120 @@ TFunctionPtr operator/(const T&, const TFunction&) {
         throw std::logic_error("Unsupported type for operator/");
 }
 
-double GradientDescentRoot(TFunctionPtr func, double initial_guess, int iterations, double learning_rate = 0.1) {
-    double x = initial_guess;
-    for (int i = 0; i < iterations; ++i) {
-        double dfx = func->GetDeriv(x);
-        double f = (*func)(x);
-        std::cout << x << std::endl;
-        x = x - learning_rate * (f / dfx);
+// Выражение, скомпилированное в ленту: вычисление идёт одним циклом по массиву инструкций,
+// без виртуальных вызовов и обращений к shared_ptr. Значения и производные совпадают
+// с operator() и GetDeriv исходного дерева: формулы и порядок операций те же.
+class CompiledFunction {
+    static constexpr int kInlineDepth = 32;
+    Tape tape_;
+
+    // val и der - стеки глубины tape_.maxDepth; при Deriv == false der не используется.
+    template <bool Deriv>
+    double Run(double x, double* val, double* der) const {
+        int sp = 0;
+        for (const Tape::Instr& in : tape_.code) {
+            switch (in.op) {
+            case Tape::Op::Ident:
+                val[sp] = x;
+                if constexpr (Deriv) der[sp] = 1.0;
+                ++sp;
+                break;
+            case Tape::Op::Const:
+                val[sp] = tape_.consts[in.arg];
+                if constexpr (Deriv) der[sp] = 0.0;
+                ++sp;
+                break;
+            case Tape::Op::Power:
+                val[sp] = std::pow(x, in.arg);
+                if constexpr (Deriv) der[sp] = in.arg == 0 ? 0.0 : in.arg * std::pow(x, in.arg - 1);
+                ++sp;
+                break;
+            case Tape::Op::Exp:
+                val[sp] = std::exp(x);
+                if constexpr (Deriv) der[sp] = val[sp];
+                ++sp;
+                break;
+            case Tape::Op::Poly: {
+                const double* c = tape_.consts.data() + in.arg;
+                double result = 0;
+                double x_power = 1;
+                for (int i = 0; i < in.count; ++i) {
+                    result += c[i] * x_power;
+                    x_power *= x;
+                }
+                val[sp] = result;
+                if constexpr (Deriv) {
+                    result = 0;
+                    x_power = 1;
+                    for (int i = 1; i < in.count; ++i) {
+                        result += c[i] * i * x_power;
+                        x_power *= x;
+                    }
+                    der[sp] = result;
+                }
+                ++sp;
+                break;
+            }
+            case Tape::Op::Add:
+                --sp;
+                val[sp - 1] += val[sp];
+                if constexpr (Deriv) der[sp - 1] += der[sp];
+                break;
+            case Tape::Op::Sub:
+                --sp;
+                val[sp - 1] -= val[sp];
+                if constexpr (Deriv) der[sp - 1] -= der[sp];
+                break;
+            case Tape::Op::Mul: {
+                --sp;
+                double f = val[sp - 1], g = val[sp];
+                val[sp - 1] = f * g;
+                if constexpr (Deriv) der[sp - 1] = der[sp - 1] * g + f * der[sp];
+                break;
+            }
+            case Tape::Op::Div: {
+                --sp;
+                double f = val[sp - 1], g = val[sp];
+                if (std::abs(g) < 1e-12) {
+                    throw std::logic_error(Deriv ? "Division by zero in derivative" : "Division by zero");
+                }
+                val[sp - 1] = f / g;
+                if constexpr (Deriv) der[sp - 1] = (der[sp - 1] * g - f * der[sp]) / (g * g);
+                break;
+            }
+            }
+        }
+        return Deriv ? der[0] : val[0];
+    }
+
+public:
+    explicit CompiledFunction(Tape tape) : tape_(std::move(tape)) {}
+
+    double operator()(double x) const {
+        if (tape_.maxDepth <= kInlineDepth) {
+            double val[kInlineDepth];
+            return Run<false>(x, val, nullptr);
+        }
+        std::vector<double> val(tape_.maxDepth);
+        return Run<false>(x, val.data(), nullptr);
+    }
+
+    double GetDeriv(double x) const {
+        if (tape_.maxDepth <= kInlineDepth) {
+            double val[kInlineDepth], der[kInlineDepth];
+            return Run<true>(x, val, der);
+        }
+        std::vector<double> val(tape_.maxDepth), der(tape_.maxDepth);
+        return Run<true>(x, val.data(), der.data());
     }
-    return x;
+
+    size_t Size() const { return tape_.code.size(); }
+};
+
+inline CompiledFunction Compile(TFunctionPtr func) {
+    Tape tape;
+    func->EmitTo(tape);
+    return CompiledFunction(std::move(tape));
 }
 
 #endif
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "function.h"
+#include "roots.h"
 #include <iostream>
 
 int main() {
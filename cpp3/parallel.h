@@ -0,0 +1,242 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "function.h"
+
+// Пул потоков с перехватом работы: у каждого потока своя очередь, свои задачи он берёт
+// с конца, а при пустой очереди забирает самые старые задачи из чужих (с начала).
+class ThreadPool {
+    struct Queue {
+        std::mutex m;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> pending_{0};  // задачи в очередях, ещё не взятые на выполнение
+    std::atomic<size_t> next_{0};     // очередь для задач извне пула
+    bool stop_ = false;
+
+    // Пул и номер очереди, которым принадлежит текущий поток; у чужих потоков pool == nullptr.
+    struct Worker {
+        const ThreadPool* pool = nullptr;
+        int index = -1;
+    };
+    static Worker& Current() {
+        static thread_local Worker worker;
+        return worker;
+    }
+
+    // Номер очереди потока этого пула, -1 для остальных потоков, в том числе потоков других пулов.
+    int Self() const {
+        const Worker& w = Current();
+        return w.pool == this ? w.index : -1;
+    }
+
+    bool Pop(size_t q, bool back, std::function<void()>& task) {
+        std::lock_guard<std::mutex> lock(queues_[q]->m);
+        auto& tasks = queues_[q]->tasks;
+        if (tasks.empty()) return false;
+        if (back) {
+            task = std::move(tasks.back());
+            tasks.pop_back();
+        } else {
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        pending_--;
+        return true;
+    }
+
+    // Выполняет одну задачу: свою, а если своих нет - украденную. false, если задач нет.
+    bool TryRunOne(int self) {
+        std::function<void()> task;
+        size_t n = queues_.size();
+        bool found = self >= 0 && Pop(self, true, task);
+        size_t start = self >= 0 ? self + 1 : next_.load();
+        for (size_t k = 0; !found && k < n; ++k) found = Pop((start + k) % n, false, task);
+        if (!found) return false;
+        task();
+        return true;
+    }
+
+    void WorkerLoop(int self) {
+        Current() = {this, self};
+        while (true) {
+            if (TryRunOne(self)) continue;
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            wake_.wait(lock, [this] { return stop_ || pending_ > 0; });
+            if (stop_ && pending_ == 0) return;
+        }
+    }
+
+public:
+    // threads == 0 - по числу ядер.
+    explicit ThreadPool(unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < threads; ++i) queues_.push_back(std::make_unique<Queue>());
+        for (unsigned i = 0; i < threads; ++i) threads_.emplace_back(&ThreadPool::WorkerLoop, this, int(i));
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread& t : threads_) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t Size() const { return threads_.size(); }
+
+    // Задача из потока пула попадает в его очередь, задача извне - в очереди по кругу.
+    void Submit(std::function<void()> task) {
+        int self = Self();
+        size_t q = self >= 0 ? size_t(self) : next_++ % queues_.size();
+        // pending_ растёт до публикации задачи: иначе её могут украсть и уменьшить счётчик раньше.
+        // Увеличение под sleepMutex_, чтобы засыпающий поток не пропустил notify_one.
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            pending_++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queues_[q]->m);
+            queues_[q]->tasks.push_back(std::move(task));
+        }
+        wake_.notify_one();
+    }
+
+    // body(begin, end) на отрезках [0, n) длиной grain. Вызывающий поток тоже берёт задачи,
+    // поэтому ParallelFor можно вызывать изнутри задачи пула. Первое исключение из body
+    // пробрасывается после завершения всех отрезков.
+    void ParallelFor(size_t n, size_t grain, const std::function<void(size_t, size_t)>& body) {
+        if (n == 0) return;
+        grain = std::max<size_t>(grain, 1);
+        std::atomic<size_t> left{(n + grain - 1) / grain};
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        for (size_t begin = 0; begin < n; begin += grain) {
+            size_t end = std::min(n, begin + grain);
+            Submit([&, begin, end] {
+                try {
+                    body(begin, end);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) error = std::current_exception();
+                }
+                left--;
+            });
+        }
+        while (left > 0) {
+            if (!TryRunOne(Self())) std::this_thread::yield();
+        }
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+// Параллельное вычисление на сетках и поиск всех корней на отрезке. Деревья TFunction
+// неизменяемы, поэтому потоки вычисляют одно и то же дерево без блокировок (см. TFunction).
+class ParallelEvaluator {
+    ThreadPool pool_;
+    size_t grain_;
+
+    // Точка i равномерной сетки из n точек на [a, b]; концы попадают в сетку точно.
+    static double GridPoint(double a, double b, size_t n, size_t i) {
+        return n == 1 ? a : i + 1 == n ? b : a + (b - a) * double(i) / double(n - 1);
+    }
+
+    std::vector<double> Grid(const TFunctionPtr& f, double a, double b, size_t n, bool deriv) {
+        std::vector<double> out(n);
+        pool_.ParallelFor(n, grain_, [&](size_t begin, size_t end) {
+            std::vector<double> xs(end - begin);
+            for (size_t i = begin; i < end; ++i) xs[i - begin] = GridPoint(a, b, n, i);
+            std::span<double> dst(out.data() + begin, end - begin);
+            if (deriv) f->EvaluateDeriv(xs, dst);
+            else f->Evaluate(xs, dst);
+        });
+        return out;
+    }
+
+    // Бисекция на [lo, hi] со сменой знака, пока середина отличается от концов.
+    static double Bisect(const TFunction& f, double lo, double hi, double flo) {
+        while (true) {
+            double mid = lo + (hi - lo) / 2;
+            if (mid <= lo || mid >= hi) return std::abs(flo) <= std::abs(f(hi)) ? lo : hi;
+            double fmid = f(mid);
+            if (fmid == 0) return mid;
+            if ((fmid < 0) == (flo < 0)) {
+                lo = mid;
+                flo = fmid;
+            } else {
+                hi = mid;
+            }
+        }
+    }
+
+public:
+    // threads == 0 - по числу ядер; grain - точек на одну задачу пула.
+    explicit ParallelEvaluator(unsigned threads = 0, size_t grain = 16384) : pool_(threads), grain_(grain) {}
+
+    size_t Threads() const { return pool_.Size(); }
+
+    // f в n точках равномерной сетки на [a, b].
+    std::vector<double> EvaluateGrid(const TFunctionPtr& f, double a, double b, size_t n) {
+        return Grid(f, a, b, n, false);
+    }
+
+    // f' в тех же точках.
+    std::vector<double> DerivGrid(const TFunctionPtr& f, double a, double b, size_t n) {
+        return Grid(f, a, b, n, true);
+    }
+
+    // Корни f на [a, b] по возрастанию. Сетка из samples точек просматривается параллельными
+    // отрезками; каждая смена знака между соседними точками уточняется бисекцией отдельной
+    // задачей, нули в узлах сетки берутся как есть. Корни чётной кратности и пары корней
+    // ближе шага сетки не находятся. f должна быть определена на всём [a, b].
+    std::vector<double> FindAllRoots(const TFunctionPtr& f, double a, double b, size_t samples = 1 << 20) {
+        samples = std::max<size_t>(samples, 2);
+        size_t chunks = (samples + grain_ - 1) / grain_;
+        std::vector<std::vector<double>> roots(chunks);
+        pool_.ParallelFor(chunks, 1, [&](size_t c, size_t) {
+            size_t begin = c * grain_, end = std::min(samples, begin + grain_);
+            // Отрезок захватывает первую точку следующего, чтобы не потерять смену знака на стыке.
+            size_t last = std::min(samples - 1, end);
+            std::vector<double> xs(last - begin + 1), fs(xs.size());
+            for (size_t i = begin; i <= last; ++i) xs[i - begin] = GridPoint(a, b, samples, i);
+            f->Evaluate(xs, fs);
+            std::vector<size_t> brackets;  // смена знака между xs[i] и xs[i + 1]
+            std::vector<double>& found = roots[c];
+            for (size_t i = 0; i < end - begin; ++i) {
+                if (fs[i] == 0) found.push_back(xs[i]);
+                else if (i + 1 < xs.size() && fs[i + 1] != 0 && (fs[i] < 0) != (fs[i + 1] < 0))
+                    brackets.push_back(i);
+            }
+            // Каждая скобка уточняется отдельной задачей пула.
+            std::vector<double> refined(brackets.size());
+            pool_.ParallelFor(brackets.size(), 1, [&](size_t k, size_t) {
+                size_t i = brackets[k];
+                refined[k] = Bisect(*f, xs[i], xs[i + 1], fs[i]);
+            });
+            found.insert(found.end(), refined.begin(), refined.end());
+        });
+        std::vector<double> all;
+        for (const std::vector<double>& r : roots) all.insert(all.end(), r.begin(), r.end());
+        std::sort(all.begin(), all.end());
+        return all;
+    }
+};
+
+#endif
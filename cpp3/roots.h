@@ -0,0 +1,192 @@
+#ifndef ROOTS_H
+#define ROOTS_H
+
+#include <cmath>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include "function.h"
+#include "parallel.h"
+
+// Поиск корня f(x) = 0: Ньютон, Ньютон с подстраховкой бисекцией, Брент и секущие.
+// Все методы останавливаются, как только |f(x)| <= ftol или шаг (ширина скобки) меньше
+// xtol * (1 + |x|), и ничего не печатают: ход итераций можно получить через trace.
+
+struct RootOptions {
+    double xtol = 1e-12;
+    double ftol = 0.0;
+    int maxIter = 100;
+    double damping = 1.0;  // множитель шага Ньютона (learning_rate у GradientDescentRoot)
+    // Вызывается после каждой итерации с её номером, новым приближением и f в нём.
+    // В MultiStartRoots вызывается из потоков пула одновременно.
+    std::function<void(int, double, double)> trace;
+};
+
+struct RootResult {
+    double root;
+    double residual;  // |f(root)|
+    int iterations;
+    bool converged;
+};
+
+inline bool RootStepSmall(double step, double x, const RootOptions& opts) {
+    return std::abs(step) <= opts.xtol * (1 + std::abs(x));
+}
+
+inline void RootTrace(const RootOptions& opts, int iter, double x, double fx) {
+    if (opts.trace) opts.trace(iter, x, fx);
+}
+
+// Скобка [a, b] со сменой знака; fa, fb - значения на концах. Ноль на конце - сразу ответ.
+inline bool CheckRootBracket(double a, double b, double fa, double fb, RootResult& result) {
+    if (fa == 0 || fb == 0) {
+        result = {fa == 0 ? a : b, 0.0, 0, true};
+        return true;
+    }
+    if ((fa < 0) == (fb < 0)) throw std::invalid_argument("Root is not bracketed: f(a) and f(b) have the same sign");
+    return false;
+}
+
+// Метод Ньютона из x0. Останавливается без сходимости, если f'(x) = 0 или шаг не конечен.
+inline RootResult NewtonRoot(const TFunctionPtr& f, double x0, const RootOptions& opts = {}) {
+    double x = x0;
+    Dual d = f->Eval(x);
+    for (int iter = 1; iter <= opts.maxIter; ++iter) {
+        if (std::abs(d.value) <= opts.ftol) return {x, std::abs(d.value), iter - 1, true};
+        double step = opts.damping * d.value / d.deriv;
+        if (d.deriv == 0 || !std::isfinite(step)) return {x, std::abs(d.value), iter - 1, false};
+        x -= step;
+        d = f->Eval(x);
+        RootTrace(opts, iter, x, d.value);
+        if (RootStepSmall(step, x, opts) || std::abs(d.value) <= opts.ftol)
+            return {x, std::abs(d.value), iter, true};
+    }
+    return {x, std::abs(d.value), opts.maxIter, false};
+}
+
+// Метод секущих по двум начальным точкам.
+inline RootResult SecantRoot(const TFunctionPtr& f, double x0, double x1, const RootOptions& opts = {}) {
+    double f0 = (*f)(x0), f1 = (*f)(x1);
+    for (int iter = 1; iter <= opts.maxIter; ++iter) {
+        if (std::abs(f1) <= opts.ftol) return {x1, std::abs(f1), iter - 1, true};
+        double step = f1 * (x1 - x0) / (f1 - f0);
+        if (f1 == f0 || !std::isfinite(step)) return {x1, std::abs(f1), iter - 1, false};
+        x0 = x1;
+        f0 = f1;
+        x1 -= step;
+        f1 = (*f)(x1);
+        RootTrace(opts, iter, x1, f1);
+        if (RootStepSmall(step, x1, opts) || std::abs(f1) <= opts.ftol) return {x1, std::abs(f1), iter, true};
+    }
+    return {x1, std::abs(f1), opts.maxIter, false};
+}
+
+// Ньютон внутри скобки [a, b] со сменой знака: шаг, выходящий из скобки или сокращающий
+// её медленнее бисекции, заменяется бисекцией. Сходится всегда.
+inline RootResult SafeNewtonRoot(const TFunctionPtr& f, double a, double b, const RootOptions& opts = {}) {
+    double fa = (*f)(a), fb = (*f)(b);
+    RootResult result;
+    if (CheckRootBracket(a, b, fa, fb, result)) return result;
+    // lo - конец с f < 0, hi - с f > 0.
+    double lo = fa < 0 ? a : b, hi = fa < 0 ? b : a;
+    double x = (a + b) / 2, prevStep = std::abs(b - a), step = prevStep;
+    Dual d = f->Eval(x);
+    for (int iter = 1; iter <= opts.maxIter; ++iter) {
+        if (std::abs(d.value) <= opts.ftol) return {x, std::abs(d.value), iter - 1, true};
+        bool outside = ((x - hi) * d.deriv - d.value) * ((x - lo) * d.deriv - d.value) > 0;
+        if (outside || std::abs(2 * d.value) > std::abs(prevStep * d.deriv)) {
+            prevStep = step;
+            step = (hi - lo) / 2;
+            x = lo + step;
+        } else {
+            prevStep = step;
+            step = d.value / d.deriv;
+            x -= step;
+        }
+        d = f->Eval(x);
+        RootTrace(opts, iter, x, d.value);
+        if (RootStepSmall(step, x, opts) || std::abs(d.value) <= opts.ftol)
+            return {x, std::abs(d.value), iter, true};
+        if (d.value < 0) lo = x;
+        else hi = x;
+    }
+    return {x, std::abs(d.value), opts.maxIter, false};
+}
+
+// Метод Брента на скобке [a, b] со сменой знака: обратная квадратичная интерполяция
+// и секущие с откатом на бисекцию. Производная не нужна.
+inline RootResult BrentRoot(const TFunctionPtr& f, double a, double b, const RootOptions& opts = {}) {
+    double fa = (*f)(a), fb = (*f)(b);
+    RootResult result;
+    if (CheckRootBracket(a, b, fa, fb, result)) return result;
+    double c = b, fc = fb, d = b - a, e = d;
+    for (int iter = 1; iter <= opts.maxIter; ++iter) {
+        if ((fb > 0) == (fc > 0)) {
+            c = a;
+            fc = fa;
+            d = e = b - a;
+        }
+        if (std::abs(fc) < std::abs(fb)) {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+        double tol = opts.xtol * (1 + std::abs(b)) / 2;
+        double m = (c - b) / 2;
+        if (std::abs(m) <= tol || std::abs(fb) <= opts.ftol) return {b, std::abs(fb), iter - 1, true};
+        if (std::abs(e) >= tol && std::abs(fa) > std::abs(fb)) {
+            double s = fb / fa, p, q;
+            if (a == c) {
+                p = 2 * m * s;
+                q = 1 - s;
+            } else {
+                double r = fb / fc, t = fa / fc;
+                p = s * (2 * m * t * (t - r) - (b - a) * (r - 1));
+                q = (t - 1) * (r - 1) * (s - 1);
+            }
+            if (p > 0) q = -q;
+            else p = -p;
+            if (2 * p < std::min(3 * m * q - std::abs(tol * q), std::abs(e * q))) {
+                e = d;
+                d = p / q;
+            } else {
+                d = m;
+                e = m;
+            }
+        } else {
+            d = m;
+            e = m;
+        }
+        a = b;
+        fa = fb;
+        b += std::abs(d) > tol ? d : (m > 0 ? tol : -tol);
+        fb = (*f)(b);
+        RootTrace(opts, iter, b, fb);
+    }
+    return {b, std::abs(fb), opts.maxIter, std::abs(fb) <= opts.ftol};
+}
+
+// Ньютон из каждой начальной точки guesses параллельно в пуле; результаты в порядке guesses.
+inline std::vector<RootResult> MultiStartRoots(ThreadPool& pool, const TFunctionPtr& f, std::span<const double> guesses,
+                                               const RootOptions& opts = {}) {
+    std::vector<RootResult> results(guesses.size());
+    pool.ParallelFor(guesses.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) results[i] = NewtonRoot(f, guesses[i], opts);
+    });
+    return results;
+}
+
+// Прежний интерфейс: шаг x -= learning_rate * f / f' не более iterations раз,
+// теперь с остановкой по сходимости и при f'(x) = 0.
+inline double GradientDescentRoot(TFunctionPtr func, double initial_guess, int iterations, double learning_rate = 0.1) {
+    RootOptions opts;
+    opts.maxIter = iterations;
+    opts.damping = learning_rate;
+    return NewtonRoot(func, initial_guess, opts).root;
+}
+
+#endif
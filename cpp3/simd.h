@@ -0,0 +1,118 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define FUNCTION_AVX2 1
+#endif
+
+// Векторные ядра для пакетного вычисления (TFunction::Evaluate). С -mavx2 -mfma
+// (или -march=native) обрабатывают по 4 числа за инструкцию, иначе работают
+// скалярными циклами. Массивы не обязаны быть выровнены.
+
+// out[i] = exp(x[i]). AVX2: exp(x) = 2^k * exp(r), k = round(x / ln 2), |r| <= ln 2 / 2,
+// exp(r) - ряд Тейлора до r^12 (ошибка порядка 1e-16). Четвёрки, где есть x вне
+// [-708, 709] или NaN, считаются через std::exp.
+inline void ExpBlock(const double* x, double* out, size_t n) {
+    size_t i = 0;
+#ifdef FUNCTION_AVX2
+    const __m256d lo = _mm256_set1_pd(-708.0), hi = _mm256_set1_pd(709.0);
+    const __m256d log2e = _mm256_set1_pd(1.4426950408889634);
+    const __m256d ln2hi = _mm256_set1_pd(6.93147180369123816490e-01);
+    const __m256d ln2lo = _mm256_set1_pd(1.90821492927058770002e-10);
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(x + i);
+        __m256d inRange = _mm256_and_pd(_mm256_cmp_pd(v, lo, _CMP_GE_OQ), _mm256_cmp_pd(v, hi, _CMP_LE_OQ));
+        if (_mm256_movemask_pd(inRange) != 0xF) {
+            for (size_t j = i; j < i + 4; ++j) out[j] = std::exp(x[j]);
+            continue;
+        }
+        __m256d k = _mm256_round_pd(_mm256_mul_pd(v, log2e), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256d r = _mm256_fnmadd_pd(k, ln2hi, v);
+        r = _mm256_fnmadd_pd(k, ln2lo, r);
+        __m256d p = _mm256_set1_pd(1.0 / 479001600.0);  // 1/12!
+        const double inv[] = {1.0 / 39916800.0, 1.0 / 3628800.0, 1.0 / 362880.0, 1.0 / 40320.0,
+                              1.0 / 5040.0, 1.0 / 720.0, 1.0 / 120.0, 1.0 / 24.0, 1.0 / 6.0, 0.5, 1.0, 1.0};
+        for (double c : inv) p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(c));
+        __m256i e = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(k));
+        e = _mm256_slli_epi64(_mm256_add_epi64(e, _mm256_set1_epi64x(1023)), 52);
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(p, _mm256_castsi256_pd(e)));
+    }
+#endif
+    for (; i < n; ++i) out[i] = std::exp(x[i]);
+}
+
+// val[i] = x[i]^e возведением в квадрат; при der != nullptr ещё der[i] = e * x[i]^(e-1).
+// Отрицательная степень - обратная к положительной.
+inline void PowBlock(const double* x, int e, double* val, double* der, size_t n) {
+    auto powi = [x, n](int p, double* out) {
+        unsigned m = p < 0 ? 0u - unsigned(p) : unsigned(p);
+        size_t i = 0;
+#ifdef FUNCTION_AVX2
+        for (; i + 4 <= n; i += 4) {
+            __m256d base = _mm256_loadu_pd(x + i), acc = _mm256_set1_pd(1.0);
+            for (unsigned k = m; k; k >>= 1) {
+                if (k & 1) acc = _mm256_mul_pd(acc, base);
+                base = _mm256_mul_pd(base, base);
+            }
+            if (p < 0) acc = _mm256_div_pd(_mm256_set1_pd(1.0), acc);
+            _mm256_storeu_pd(out + i, acc);
+        }
+#endif
+        for (; i < n; ++i) {
+            double base = x[i], acc = 1.0;
+            for (unsigned k = m; k; k >>= 1) {
+                if (k & 1) acc *= base;
+                base *= base;
+            }
+            out[i] = p < 0 ? 1.0 / acc : acc;
+        }
+    };
+    powi(e, val);
+    if (!der) return;
+    if (e == 0) {
+        for (size_t i = 0; i < n; ++i) der[i] = 0.0;
+        return;
+    }
+    powi(e - 1, der);
+    for (size_t i = 0; i < n; ++i) der[i] *= e;
+}
+
+// Полином c[0] + c[1] x + ... + c[m-1] x^(m-1) по схеме Горнера; производная считается
+// в том же проходе: d = d * x + p перед каждым шагом p = p * x + c[k].
+inline void HornerBlock(const double* c, size_t m, const double* x, double* val, double* der, size_t n) {
+    size_t i = 0;
+    if (m == 0) {
+        for (; i < n; ++i) {
+            val[i] = 0.0;
+            if (der) der[i] = 0.0;
+        }
+        return;
+    }
+#ifdef FUNCTION_AVX2
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(x + i);
+        __m256d p = _mm256_set1_pd(c[m - 1]), d = _mm256_setzero_pd();
+        for (size_t k = m - 1; k-- > 0;) {
+            d = _mm256_fmadd_pd(d, v, p);
+            p = _mm256_fmadd_pd(p, v, _mm256_set1_pd(c[k]));
+        }
+        _mm256_storeu_pd(val + i, p);
+        if (der) _mm256_storeu_pd(der + i, d);
+    }
+#endif
+    for (; i < n; ++i) {
+        double p = c[m - 1], d = 0.0;
+        for (size_t k = m - 1; k-- > 0;) {
+            d = d * x[i] + p;
+            p = p * x[i] + c[k];
+        }
+        val[i] = p;
+        if (der) der[i] = d;
+    }
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "function.h"
+#include "parallel.h"
+#include "roots.h"
 
 TEST(FunctionTest, IdentityFunction) {
     IdentityFunction f;
@@ -79,6 +81,231 @@ TEST(FunctionTest, Error) {
     EXPECT_THROW({ auto sum = *f + "abc"; }, std::logic_error);
 }
 
+TEST(FunctionTest, Compile) {
+    auto x = FunctionFactory::Create("ident");
+    auto p = FunctionFactory::Create("polynomial", {7, 0, 3, 15});
+    auto e = FunctionFactory::Create("exp");
+    auto q = FunctionFactory::Create("power", {3});
+    auto c = FunctionFactory::Create("const", {2.5});
+    auto f = *(*(*p * *e) - *q) / *(*(*x * *x) + *c); // (p*e - x^3) / (x*x + 2.5)
+
+    CompiledFunction compiled = Compile(f);
+    EXPECT_EQ(compiled.Size(), 11u);
+    for (double v : {-3.0, -0.5, 0.0, 0.25, 1.0, 2.0}) {
+        EXPECT_EQ(compiled(v), (*f)(v));
+        EXPECT_EQ(compiled.GetDeriv(v), f->GetDeriv(v));
+    }
+}
+
+TEST(FunctionTest, CompileDeep) {
+    // Глубина стека больше встроенного буфера: правые поддеревья вложены.
+    TFunctionPtr f = FunctionFactory::Create("const", {1});
+    for (int i = 0; i < 40; ++i) {
+        f = *FunctionFactory::Create("polynomial", {0.5, 0.01 * i}) + *f;
+    }
+    CompiledFunction compiled = Compile(f);
+    EXPECT_EQ(compiled(1.5), (*f)(1.5));
+    EXPECT_EQ(compiled.GetDeriv(1.5), f->GetDeriv(1.5));
+}
+
+TEST(FunctionTest, CompileDivisionByZero) {
+    auto f = *FunctionFactory::Create("const", {1}) / *FunctionFactory::Create("ident");
+    CompiledFunction compiled = Compile(f);
+    EXPECT_THROW(compiled(0.0), std::logic_error);
+    EXPECT_THROW(compiled.GetDeriv(0.0), std::logic_error);
+}
+
+TEST(FunctionTest, Eval) {
+    auto p = FunctionFactory::Create("polynomial", {7, 0, 3, 15});
+    auto e = FunctionFactory::Create("exp");
+    auto q = FunctionFactory::Create("power", {2});
+    auto f = *(*p * *e) / *(*q + *FunctionFactory::Create("const", {1})); // p*e / (x^2 + 1)
+    for (double v : {-2.0, 0.0, 0.5, 3.0}) {
+        Dual d = f->Eval(v);
+        EXPECT_EQ(d.value, (*f)(v));
+        EXPECT_EQ(d.deriv, f->GetDeriv(v));
+    }
+    auto g = *FunctionFactory::Create("ident") / *FunctionFactory::Create("const", {0});
+    EXPECT_THROW(g->Eval(1.0), std::logic_error);
+}
+
+TEST(FunctionTest, BatchEvaluate) {
+    auto p = FunctionFactory::Create("polynomial", {7, 0, 3, 15});
+    auto e = FunctionFactory::Create("exp");
+    auto q = FunctionFactory::Create("power", {-3});
+    auto c = FunctionFactory::Create("const", {2.5});
+    auto f = *(*(*p * *e) - *q) / *(*FunctionFactory::Create("power", {2}) + *c);
+
+    // Длина не кратна ни блоку, ни ширине вектора.
+    std::vector<double> xs;
+    for (int i = 0; i < 1000; ++i) xs.push_back(-3.0 + 0.00613 * i);
+    std::vector<double> val(xs.size()), der(xs.size());
+    f->Evaluate(xs, val);
+    f->EvaluateDeriv(xs, der);
+    for (size_t i = 0; i < xs.size(); ++i) {
+        EXPECT_NEAR(val[i], (*f)(xs[i]), 1e-12 * std::max(1.0, std::abs(val[i])));
+        EXPECT_NEAR(der[i], f->GetDeriv(xs[i]), 1e-12 * std::max(1.0, std::abs(der[i])));
+    }
+
+    std::vector<double> wide = {-800, -745, -1, 0, 1e-3, 0.5, 300, 709.5, 710};
+    std::vector<double> ev(wide.size());
+    e->Evaluate(wide, ev);
+    for (size_t i = 0; i + 1 < wide.size(); ++i) {
+        EXPECT_NEAR(ev[i], std::exp(wide[i]), 1e-14 * std::exp(wide[i]));
+    }
+    EXPECT_TRUE(std::isinf(ev.back()));
+
+    std::vector<double> small(3);
+    EXPECT_THROW(f->Evaluate(xs, small), std::invalid_argument);
+    auto g = *FunctionFactory::Create("ident") / *FunctionFactory::Create("polynomial", {-1, 1});
+    std::vector<double> at = {0.5, 1.0}, out(2);
+    EXPECT_THROW(g->Evaluate(at, out), std::logic_error);
+}
+
+TEST(FunctionTest, ConcurrentEvaluation) {
+    auto p = FunctionFactory::Create("polynomial", {1, -2, 0.5, 3});
+    auto f = *(*p * *FunctionFactory::Create("exp")) / *FunctionFactory::Create("polynomial", {2, 0, 1});
+    std::vector<double> xs;
+    for (int i = 0; i < 4096; ++i) xs.push_back(-4.0 + 0.002 * i);
+    std::vector<double> val(xs.size()), der(xs.size());
+    for (size_t i = 0; i < xs.size(); ++i) {
+        val[i] = (*f)(xs[i]);
+        der[i] = f->GetDeriv(xs[i]);
+    }
+    std::vector<double> batch(xs.size());
+    f->Evaluate(xs, batch);
+
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&] {
+            std::vector<double> out(xs.size());
+            for (int rep = 0; rep < 20; ++rep) {
+                for (size_t i = 0; i < xs.size(); ++i) {
+                    if ((*f)(xs[i]) != val[i] || f->GetDeriv(xs[i]) != der[i]) mismatches++;
+                }
+                f->Evaluate(xs, out);
+                if (out != batch) mismatches++;
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    EXPECT_EQ(mismatches, 0);
+}
+
+TEST(FunctionTest, ParallelGrid) {
+    ParallelEvaluator evaluator(4, 1000);
+    auto f = *FunctionFactory::Create("power", {3}) - *FunctionFactory::Create("exp");
+    std::vector<double> val = evaluator.EvaluateGrid(f, -2, 3, 10007);
+    std::vector<double> der = evaluator.DerivGrid(f, -2, 3, 10007);
+    ASSERT_EQ(val.size(), 10007u);
+    std::vector<double> xs(val.size()), expected(val.size()), expectedDer(val.size());
+    for (size_t i = 0; i < xs.size(); ++i) xs[i] = i + 1 == xs.size() ? 3.0 : -2 + 5.0 * i / (xs.size() - 1);
+    f->Evaluate(xs, expected);
+    f->EvaluateDeriv(xs, expectedDer);
+    EXPECT_EQ(val, expected);
+    EXPECT_EQ(der, expectedDer);
+}
+
+TEST(FunctionTest, FindAllRoots) {
+    ParallelEvaluator evaluator(4, 512);
+    // (x + 3)(x - 1)(x - 2) = x^3 - 7x + 6
+    auto f = FunctionFactory::Create("polynomial", {6, -7, 0, 1});
+    std::vector<double> roots = evaluator.FindAllRoots(f, -5, 5, 10000);
+    ASSERT_EQ(roots.size(), 3u);
+    EXPECT_NEAR(roots[0], -3.0, 1e-12);
+    EXPECT_NEAR(roots[1], 1.0, 1e-12);
+    EXPECT_NEAR(roots[2], 2.0, 1e-12);
+
+    auto g = *FunctionFactory::Create("const", {1}) / *FunctionFactory::Create("ident");
+    EXPECT_THROW(evaluator.FindAllRoots(g, -1, 1, 3), std::logic_error);
+}
+
+TEST(FunctionTest, RootFinders) {
+    // (x + 3)(x - 1)(x - 2) = x^3 - 7x + 6
+    auto f = FunctionFactory::Create("polynomial", {6, -7, 0, 1});
+
+    RootResult newton = NewtonRoot(f, 3.0);
+    EXPECT_TRUE(newton.converged);
+    EXPECT_NEAR(newton.root, 2.0, 1e-12);
+    EXPECT_LT(newton.iterations, 10);
+    EXPECT_LE(newton.residual, 1e-12);
+
+    RootResult secant = SecantRoot(f, 0.0, 0.5);
+    EXPECT_TRUE(secant.converged);
+    EXPECT_NEAR(secant.root, 1.0, 1e-12);
+
+    RootResult safe = SafeNewtonRoot(f, -5.0, 0.0);
+    EXPECT_TRUE(safe.converged);
+    EXPECT_NEAR(safe.root, -3.0, 1e-12);
+
+    auto g = *FunctionFactory::Create("exp") - *FunctionFactory::Create("const", {2});
+    RootResult brent = BrentRoot(g, 0.0, 3.0);
+    EXPECT_TRUE(brent.converged);
+    EXPECT_NEAR(brent.root, std::log(2.0), 1e-12);
+    EXPECT_LT(brent.iterations, 20);
+
+    EXPECT_THROW(BrentRoot(f, 3.0, 4.0), std::invalid_argument);
+    EXPECT_EQ(BrentRoot(f, 1.0, 1.5).root, 1.0);
+}
+
+TEST(FunctionTest, RootFinderStops) {
+    auto f = FunctionFactory::Create("polynomial", {-4, 0, 1}); // x^2 - 4
+    RootResult flat = NewtonRoot(f, 0.0); // f'(0) = 0
+    EXPECT_FALSE(flat.converged);
+    EXPECT_EQ(flat.iterations, 0);
+
+    int traced = 0;
+    RootOptions opts;
+    opts.ftol = 1e-9;
+    opts.trace = [&](int iter, double, double) { traced = iter; };
+    RootResult r = NewtonRoot(f, 3.0, opts);
+    EXPECT_TRUE(r.converged);
+    EXPECT_EQ(traced, r.iterations);
+    EXPECT_LE(r.residual, 1e-9);
+
+    // Прежний интерфейс: сходится и останавливается раньше лимита итераций.
+    EXPECT_NEAR(GradientDescentRoot(f, 3.0, 1000), 2.0, 1e-9);
+}
+
+TEST(FunctionTest, MultiStartRoots) {
+    ThreadPool pool(4);
+    auto f = FunctionFactory::Create("polynomial", {6, -7, 0, 1});
+    std::vector<double> guesses = {-10, -4, 0.8, 1.2, 1.8, 5, 100};
+    std::vector<RootResult> results = MultiStartRoots(pool, f, guesses);
+    ASSERT_EQ(results.size(), guesses.size());
+    for (size_t i = 0; i < guesses.size(); ++i) {
+        EXPECT_TRUE(results[i].converged);
+        RootResult single = NewtonRoot(f, guesses[i]);
+        EXPECT_EQ(results[i].root, single.root);
+        EXPECT_EQ(results[i].iterations, single.iterations);
+    }
+    EXPECT_NEAR(results[0].root, -3.0, 1e-12);
+    EXPECT_NEAR(results[2].root, 1.0, 1e-12);
+    EXPECT_NEAR(results[6].root, 2.0, 1e-12);
+}
+
+TEST(FunctionTest, NestedPools) {
+    // Задачи одного пула вызывают ParallelFor другого, меньшего: номер потока внешнего пула
+    // не должен использоваться как номер очереди внутреннего.
+    ThreadPool outer(8), inner(2);
+    std::atomic<int> calls{0};
+    outer.ParallelFor(1024, 1, [&](size_t, size_t) {
+        inner.ParallelFor(4, 1, [&](size_t begin, size_t end) { calls += int(end - begin); });
+    });
+    EXPECT_EQ(calls, 1024 * 4);
+
+    auto f = FunctionFactory::Create("polynomial", {6, -7, 0, 1});
+    std::vector<double> guesses = {-10, 0.8, 5};
+    std::vector<std::vector<RootResult>> nested(256);
+    outer.ParallelFor(nested.size(), 1, [&](size_t i, size_t) { nested[i] = MultiStartRoots(inner, f, guesses); });
+    for (const auto& results : nested) {
+        ASSERT_EQ(results.size(), guesses.size());
+        EXPECT_NEAR(results[0].root, -3.0, 1e-12);
+        EXPECT_NEAR(results[2].root, 2.0, 1e-12);
+    }
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();